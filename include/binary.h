@@ -0,0 +1,63 @@
+#ifndef _BINARY_H
+#define _BINARY_H
+
+#include <cstdint>
+#include <string>
+
+#include "canva.h"
+#include "contour.h"
+#include "point.h"
+
+namespace Kage {
+
+    // 默认量化步长，取2的幂使解码后的坐标可被double精确表示
+    const double BINARY_STEP = 1.0 / 64;
+
+    // 二进制格式：
+    // "KGO" 版本(1字节) 步长(double，小端8字节) 轮廓数(varint)
+    // 每个轮廓：点数*2+是否闭合(varint) 点类型(每点2位) 坐标差分(zigzag varint)
+    // 含有洞（Contour::isHole）时版本为2，轮廓开头为点数*4+是否洞*2+是否闭合
+    // 坐标按步长量化为整数，差分跨轮廓连续；量化后的结果可无损往返
+    // 步长为0时坐标按原始double存储，不做量化
+    // 若步长非法或存在非法坐标则返回空字符串
+    std::string Canva2Binary(Canva canva, double step = BINARY_STEP);
+
+    // 直接在缓冲区上读取的解码器，不复制数据；缓冲区须在使用期间有效
+    class CanvaView {
+        const uint8_t* _begin;
+        const uint8_t* _end;
+        const uint8_t* _body; // 第一个轮廓的开头
+        const uint8_t* _pos;
+        const uint8_t* _tags;
+        double         _step;
+        size_t         _size;
+        size_t         _contour;   // 已读的轮廓数
+        size_t         _remaining; // 当前轮廓中未读的点数
+        size_t         _tagIndex;
+        int64_t        _x, _y;
+        bool           _holes; // 版本2，轮廓开头含有洞的标记
+        bool           _hole;  // 当前轮廓是否为洞
+        bool           _vaild;
+
+        bool ReadVarint(uint64_t& v);
+
+    public:
+        CanvaView(const void* data, size_t size);
+        CanvaView(const std::string& data);
+
+        bool   isVaild();
+        double Step();
+        size_t Size();
+
+        void Rewind();
+        bool NextContour(size_t& points, bool& closed);
+        bool isHole(); // 当前轮廓是否为洞
+        bool NextPoint(Point& p, ptType& type);
+
+        // 解码为Canva，失败时返回false且不修改canva
+        bool ToCanva(Canva& canva);
+    };
+
+} // namespace Kage
+
+#endif
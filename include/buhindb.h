@@ -0,0 +1,77 @@
+#ifndef _BUHINDB_H
+#define _BUHINDB_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gwdata.h"
+
+namespace Kage {
+
+    // 每层按编号的5位分支，SymbolTable分配的编号是连续的，树的高度很小
+    const unsigned BUHIN_DB_BITS = 5;
+    // 部件名索引按名称的哈希值分支的层数，共有32768个叶子
+    const unsigned BUHIN_NAME_LEVELS = 3;
+
+    typedef std::shared_ptr<const std::vector<Stroke>> BuhinData;
+
+    // 内部节点只有children，叶子只有data
+    typedef struct BuhinNode {
+        std::vector<std::shared_ptr<const BuhinNode>> children;
+        std::vector<BuhinData>                        data;
+    } BuhinNode;
+
+    // 内部节点只有children，叶子只有entries（部件名与编号）
+    typedef struct BuhinNameNode {
+        std::vector<std::shared_ptr<const BuhinNameNode>> children;
+        std::vector<std::pair<std::string, uint32_t>>     entries;
+    } BuhinNameNode;
+
+    typedef struct {
+        std::shared_ptr<const BuhinNode>     root;
+        unsigned                             depth; // 内部节点的层数
+        size_t                               size;
+        std::shared_ptr<const BuhinNameNode> names; // 已存入部件的名称
+    } BuhinVersion;
+
+    // 部件数据库某一时刻的只读版本，持有期间不受之后写入的影响
+    class BuhinSnapshot {
+        std::shared_ptr<const BuhinVersion> _version;
+
+    public:
+        BuhinSnapshot(std::shared_ptr<const BuhinVersion> version);
+
+        BuhinData             Find(uint32_t id) const; // 不存在时为空
+        // 按名称查找不经过SymbolTable，读取时不加任何锁
+        BuhinData             Find(std::string const& name) const;
+        size_t                Size() const;
+        std::vector<uint32_t> Ids() const;
+    };
+
+    // 写时复制的部件数据库，以部件名的编号为键
+    // 读取者取得快照后不再加锁；写入者之间互斥，只复制从根到被修改叶子的
+    // 路径并原子地发布新版本，不等待读取者
+    class BuhinDB {
+        std::mutex                          _mutex;
+        std::shared_ptr<const BuhinVersion> _current;
+
+        void Publish(uint32_t id, std::string const& name, BuhinData data);
+
+    public:
+        BuhinDB();
+
+        BuhinSnapshot Snapshot() const;
+        // name须为id在SymbolTable中对应的名称
+        void Set(uint32_t id, std::string const& name, std::vector<Stroke> data);
+        // 已存在时不修改，返回false
+        bool Insert(
+            uint32_t id, std::string const& name, std::vector<Stroke> data);
+    };
+
+} // namespace Kage
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef _CACHE_H
+#define _CACHE_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "canva.h"
+#include "gwdata.h"
+#include "kagefont.h"
+#include "lru.h"
+
+namespace Kage {
+
+    // 绘制逻辑或缓存格式改变时须递增，使旧的缓存（包括磁盘上的）失效
+    const uint32_t RENDER_CACHE_VERSION = 2;
+
+    // 已展开笔画（ExtractGlyph的结果）的稳定哈希，与平台及进程无关
+    // 同时包含字体种类、粗细与绘制参数；引用部件按名称而非编号计入
+    uint64_t    GlyphHash(std::vector<Stroke> strokes, KageFontType type,
+           double size, SymbolTable& symbols = *DefaultSymbolTable());
+    std::string GlyphHashString(uint64_t hash);
+
+    // 字形轮廓的缓存，内存中按字节数限制容量的LRU，可选的磁盘目录
+    // 可被多个Kage对象及线程共享
+    class RenderCache {
+        std::mutex                      _mutex;
+        LruCache<uint64_t, std::string> _memory;
+        std::string                     _directory;
+        size_t                          _hits = 0, _misses = 0;
+
+        std::string DiskPath(uint64_t hash);
+
+    public:
+        RenderCache(size_t capacity, std::string directory = "");
+
+        bool Get(uint64_t hash, Canva& canva);
+        void Put(uint64_t hash, Canva canva);
+        void Clear(); // 只清空内存中的缓存
+
+        size_t Bytes();
+        size_t Hits();
+        size_t Misses();
+    };
+
+} // namespace Kage
+
+#endif
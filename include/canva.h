@@ -4,15 +4,25 @@
 #include <functional>
 
 #include "contour.h"
+#include "overlap.h"
+#include "pathsink.h"
 #include "point.h"
+#include "simplify.h"
 
 namespace Kage {
 
+    class CanvaView;
+
     class Canva {
         std::vector<Contour> _contours;
+        PathSink*            _sink = nullptr;
+
+        friend class CanvaView;
 
     public:
         Canva();
+        // Push的轮廓直接输出到sink而不保存，翻转、旋转等变换对其无效
+        explicit Canva(PathSink& sink);
 
         std::vector<Contour> Contours();
 
@@ -20,6 +30,7 @@ namespace Kage {
         size_t Push(Contour contour);
         size_t Concat(Canva canva);
         size_t Size();
+        void   Replay(PathSink& sink);
 
         void DrawLine(Point p1, Point p2, double halfWidth);
         void DrawQBezier(Point p1, Point ps, Point p2,
@@ -36,6 +47,10 @@ namespace Kage {
         void Rotate90(Point p1, Point p2);
         void Rotate180(Point p1, Point p2);
         void Rotate270(Point p1, Point p2);
+
+        // 结果可能含有洞，见Canva2SVG
+        size_t RemoveOverlap(double tolerance = OVERLAP_FLATTEN_TOLERANCE);
+        size_t Simplify(double tolerance = SIMPLIFY_TOLERANCE, double grid = 0);
     };
 
 } // namespace Kage
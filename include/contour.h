@@ -24,6 +24,7 @@ namespace Kage {
         std::vector<ptType> ptTypes;
         std::vector<Point>  pts;
         bool                _isClosed;
+        bool                _isHole;
 
     public:
         Contour();
@@ -32,6 +33,7 @@ namespace Kage {
         std::vector<ptType>& PointTypes();
         std::vector<Point>&  Points();
         bool                 isClosed();
+        bool                 isHole();
 
         size_t     Push(Point p, ptType type);
         size_t     Push(PointTuple ptuple);
@@ -40,8 +42,13 @@ namespace Kage {
         size_t     Concat(Contour contour);
         PointTuple Shift();
         void       SetClosed(bool closed);
+        // RemoveOverlap的结果中的洞；未标记的轮廓不论方向均视为填充
+        void       SetHole(bool hole);
 
         size_t Size();
+        double SignedArea(); // 按控制多边形计算，y轴向下时顺时针为正
+        // 使填充的轮廓面积为正，洞为负
+        void   NormalizeOrientation();
         void   MoveTo(Point p);
         void   LineTo(Point p);
         void   QuadraticTo(Point p1, Point p2);
@@ -0,0 +1,56 @@
+#ifndef _DBCACHE_H
+#define _DBCACHE_H
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gwdata.h"
+#include "lru.h"
+
+namespace Kage {
+
+    // 数据库查询结果（已解析的笔画）的缓存，查询不到的结果同样会被缓存
+    // 同一名称的并发查询只会调用一次查询函数
+    class DBsearchCache {
+        typedef struct {
+            std::vector<Stroke>                   strokes;
+            std::chrono::steady_clock::time_point expires;
+        } DBsearchCacheEntry;
+
+        std::mutex                                  _mutex;
+        LruCache<std::string, DBsearchCacheEntry> _entries;
+        std::unordered_map<std::string, std::shared_future<std::vector<Stroke>>>
+                                  _pending;
+        std::chrono::milliseconds _ttl, _negativeTtl;
+        size_t                    _epoch = 0; // 失效操作计数，用于丢弃过期的查询结果
+        size_t                    _hits = 0, _misses = 0;
+
+        void Store(std::string name, std::vector<Stroke> strokes);
+
+    public:
+        // capacity为条目数，ttl为0时永不过期
+        DBsearchCache(size_t capacity,
+            std::chrono::milliseconds ttl = std::chrono::milliseconds(0),
+            std::chrono::milliseconds negativeTtl =
+                std::chrono::milliseconds(0));
+
+        std::vector<Stroke> Fetch(std::string name,
+            std::function<std::vector<Stroke>(std::string)> const& search);
+        bool Peek(std::string name, std::vector<Stroke>& strokes);
+        void                Put(std::string name, std::vector<Stroke> strokes);
+        void                Invalidate(std::string name);
+        void                Clear();
+
+        size_t Size();
+        size_t Hits();
+        size_t Misses();
+    };
+
+} // namespace Kage
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef _DUMP_H
+#define _DUMP_H
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "kage.h"
+
+namespace Kage {
+
+    // GlyphWiki的数据转储（dump_newest_only.txt、dump_all_versions.txt）
+    // 每行为“名称 | 关联字 | 数据”，表头、分隔线与末尾的行数统计会被跳过
+    // 读入的部件依次SetBuhin，names不为空时按出现顺序追加部件名
+    size_t LoadGlyphWikiDump(Kage& kage, std::istream& in,
+        std::vector<std::string>* names = nullptr);
+
+} // namespace Kage
+
+#endif
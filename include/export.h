@@ -2,14 +2,70 @@
 #define _EXPORT_H
 
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "canva.h"
+#include "pathsink.h"
 
 namespace Kage {
 
+    // 与kage.js相同，每个轮廓为单独填充的path元素，因此不能表示洞；
+    // RemoveOverlap的结果须使用Canva2SVGPath、Canva2CompactSVG或Canva2SFD
     std::string Canva2SVG(Canva canva);
     std::string Canva2SFD(Canva canva);
 
+    // 逐个轮廓追加到buffer中，格式与Canva2SVG的path元素相同（不含svg标签）
+    class SVGSink: public PathSink {
+        std::string& _buffer;
+        ptType       _mode;
+
+        void Coord(Point p);
+
+    public:
+        SVGSink(std::string& buffer);
+
+        void MoveTo(Point p);
+        void LineTo(Point p);
+        void QuadTo(Point p1, Point p2);
+        void CubicTo(Point p1, Point p2, Point p3);
+        void Close();
+    };
+
+    // 格式与Canva2SFD的轮廓部分相同（不含SplineSet与EndSplineSet）
+    class SFDSink: public PathSink {
+        std::string& _buffer;
+        Point        _first, _last;
+        bool         _pending = false; // 曲线段的标记取决于下一段
+
+        void Flush(bool curve);
+
+    public:
+        SFDSink(std::string& buffer);
+
+        void MoveTo(Point p);
+        void LineTo(Point p);
+        void QuadTo(Point p1, Point p2);
+        void CubicTo(Point p1, Point p2, Point p3);
+        void Close();
+    };
+
+    // 紧凑SVG输出的默认小数位数
+    const int SVG_PRECISION = 2;
+
+    // 整个字形的path数据，使用相对坐标与省略重复命令
+    // 各轮廓合并为一个path，以nonzero规则填充；输出前统一各轮廓的方向，
+    // 笔画不论原来的方向均为填充，只有标记为洞的轮廓（Contour::isHole）挖空
+    // 笔画自身折叠处的绕数仍可能与其他笔画抵消，须与逐轮廓填充完全一致时
+    // 先调用Canva::RemoveOverlap
+    std::string Canva2SVGPath(Canva canva, int precision = SVG_PRECISION);
+    std::string Canva2CompactSVG(Canva canva, int precision = SVG_PRECISION);
+    // 多个字形的sprite，每个字形为一个symbol，按columns列排列的use引用
+    // columns为0时只输出symbol
+    std::string Canva2SVGSprite(
+        std::vector<std::pair<std::string, Canva>> glyphs,
+        int precision = SVG_PRECISION, size_t columns = 16);
+
 } // namespace Kage
 
 #endif
@@ -19,6 +19,10 @@ namespace Kage {
         // 基本粗细参数
         double kWidth, kKakato, kMage;
 
+        void DrawStrokeInGlyph(
+            Canva& cv, std::vector<Stroke> const& strokes, size_t index);
+        bool IsIsolated(
+            std::vector<Stroke> const& strokes, size_t begin, size_t end);
         void DrawStroke(Canva& cv, Stroke s);
 
         void DrawLine(
@@ -29,7 +33,6 @@ namespace Kage {
     public:
         Gothic(double size = 0);
         ~Gothic() = default;
-        Canva DrawGlyph(std::vector<Stroke> strokes);
     };
 
 } // namespace Kage
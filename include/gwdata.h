@@ -7,6 +7,7 @@
 #include "utf8.h"
 
 #include "point.h"
+#include "symbol.h"
 
 namespace Kage {
 
@@ -75,8 +76,8 @@ namespace Kage {
         EndType    end;
         Point      p1, p2, p3, p4;
         signed     typeOpt, startOpt, endOpt;
-        // 引用部件专属
-        std::string buhin;
+        // 引用部件专属，部件名保存在SymbolTable中，此处只存编号
+        uint32_t    buhin;
         Point       s1, s2; // 拉伸参数
         // 特殊命令（翻转、旋转）
         SpecialInt1 spe1;
@@ -90,11 +91,27 @@ namespace Kage {
         double maxY;
     } BoundingData;
 
-    std::vector<Stroke> StrokesParse(std::string strokeStr);
-    std::string         StrokesToString(
-                std::vector<Stroke> strokes, char32_t sep = U'$');
+    // 引用部件时对坐标的一步变换，x、y两轴分别计算
+    typedef struct {
+        bool         stretch; // false: p1 + p * (p2 - p1) / 200
+        Point        p1, p2;
+        Point        dp, sp; // true: Stretch(dp, sp, p, box.min, box.max)
+        BoundingData box;
+    } BuhinTransform;
+
+    // 引用部件名通过symbols转换为编号，未指定时使用默认的表
+    std::vector<Stroke>      StrokesParse(std::string strokeStr,
+             SymbolTable& symbols = *DefaultSymbolTable());
+    std::vector<std::string> StrokesReferences(std::string strokeStr);
+    std::string              StrokesToString(std::vector<Stroke> strokes,
+                     char32_t     sep     = U'$',
+                     SymbolTable& symbols = *DefaultSymbolTable());
     double Stretch(double dp, double sp, double p, double min, double max);
     BoundingData GetBoundingBox(std::vector<Stroke> strokes);
+    BoundingData GetBoundingBox(
+        std::vector<Stroke> const& strokes, size_t begin, size_t end);
+    void TransformStrokes(std::vector<Stroke>& strokes, size_t begin,
+        size_t end, std::vector<BuhinTransform> const& steps);
     bool         isCrossBoxWithOthers(
                 std::vector<Stroke> strokesArray, size_t i, Point pb1, Point pb2);
     bool isCrossWithOthers(
@@ -2,21 +2,32 @@
 #define _KAGE_H
 
 #include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "buhindb.h"
+#include "cache.h"
 #include "canva.h"
+#include "dbcache.h"
 #include "gwdata.h"
 #include "kagefont.h"
 #include "point.h"
+#include "schedule.h"
+#include "symbol.h"
 
 namespace Kage {
 
     using DBsearchCallbackFunc = std::function<std::string(std::string)>;
+    // 批量查询，返回值与输入的名称一一对应，找不到的部件返回空字符串
+    using DBbatchSearchCallbackFunc =
+        std::function<std::vector<std::string>(std::vector<std::string>)>;
 
     typedef enum: unsigned {
         CHECK_OK,
@@ -24,36 +35,109 @@ namespace Kage {
         CHECK_LOOPBACK_DETECTED
     } CheckGlyphState;
 
+    // 整个数据库的检查结果
+    // 能到达循环引用的字形为CHECK_LOOPBACK_DETECTED，否则能到达缺失部件的为
+    // CHECK_BUHIN_NOTFOUND
+    typedef struct {
+        std::unordered_map<std::string, CheckGlyphState> states;
+        // 字形名与其直接引用的缺失部件名
+        std::vector<std::pair<std::string, std::string>> missing;
+        // 每条返回边对应一个循环，路径首尾为同一部件
+        std::vector<std::vector<std::string>> cycles;
+    } CheckReport;
+
+    // SetBuhin/PushBuhin可与绘制、检查等只读操作在不同线程同时进行
+    // 每次绘制开始时取得部件数据库的快照，不会看到绘制期间写入的部件；
+    // 按名称查找部件只读取快照，不会等待写入者或SymbolTable的锁
+    // 因持有写入用的互斥锁，Kage不能复制或移动（以前的版本可以），需要在
+    // 多处共享时用std::shared_ptr<Kage>持有
     class Kage {
-        std::unordered_map<std::string, std::vector<Stroke>> _kageDB;
-        std::shared_ptr<KageFont>                            _pkFont = nullptr;
-        double                                               _kRate;
-        DBsearchCallbackFunc _dbSearchCallback = {};
+        BuhinDB                      _kageDB;
+        std::shared_ptr<SymbolTable> _symbols = nullptr;
+        std::shared_ptr<KageFont>    _pkFont  = nullptr;
+        double                       _kRate;
+        DBsearchCallbackFunc      _dbSearchCallback      = {};
+        DBbatchSearchCallbackFunc _dbBatchSearchCallback = {};
         std::vector<Stroke>  _notDefGlyph      = {};
+        std::shared_ptr<RenderCache>   _renderCache = nullptr;
+        std::shared_ptr<DBsearchCache> _dbSearchCache = nullptr;
+        // 写入部件及以下两个索引时加锁
+        std::mutex _writeMutex;
+        // 部件 -> 直接引用该部件的字形
+        std::unordered_map<uint32_t, std::unordered_set<uint32_t>> _dependentDB;
+        std::unordered_set<uint32_t>                               _dirtyGlyphs;
         static thread_local std::unordered_set<std::string> _glyphStack;
 
-        std::vector<Stroke> GetStrokes(std::vector<Stroke> glyphData);
-        std::vector<Stroke> GetStrokesOfBuhin(
-            std::vector<Stroke> buhin, Point p1, Point p2, Point ps, Point ps2);
+        std::vector<Stroke> SearchBuhin(
+            BuhinSnapshot const& db, std::string name);
+        std::vector<Stroke> SearchBuhinId(BuhinSnapshot const& db, uint32_t id);
+        DBbatchSearchCallbackFunc BatchSearch();
+        void                UpdateDependency(uint32_t id,
+            std::vector<Stroke> const& oldData,
+            std::vector<Stroke> const& newData);
+        std::vector<Stroke> GetStrokes(BuhinSnapshot const& db,
+            std::vector<Stroke> const&                        glyphData,
+            std::vector<StrokeGroup>* groups = nullptr);
+        void GetStrokesOfBuhin(BuhinSnapshot const& db,
+            std::vector<Stroke> const&              glyphData,
+            std::vector<BuhinTransform>& transforms, std::vector<Stroke>& result,
+            std::vector<StrokeGroup>* groups = nullptr);
+        Canva DrawCached(std::vector<Stroke> const& kageStrokes,
+            std::vector<StrokeGroup> const&          groups);
+        void  MakeGlyph2(BuhinSnapshot const& db, Canva& canva,
+             std::vector<Stroke> const& data);
+        void  MakeGlyph2(BuhinSnapshot const& db, PathSink& sink,
+             std::vector<Stroke> const& data);
+        CheckGlyphState CheckGlyph(BuhinSnapshot const& db, std::string buhin);
+        CheckGlyphState CheckGlyph2(
+            BuhinSnapshot const& db, std::vector<Stroke> const& data);
+        uint64_t GetGlyphHash2(
+            BuhinSnapshot const& db, std::vector<Stroke> const& data);
+        std::pair<double, size_t> EstimateCost2(BuhinSnapshot const& db,
+            std::vector<Stroke> const& data,
+            std::unordered_map<uint32_t, std::pair<double, size_t>>& memo);
 
     public:
-        Kage(KageFontType font = KAGEFONT_MINCHO, double size = 0);
+        // symbols为空时使用DefaultSymbolTable()，传入的笔画须使用同一个表解析
+        Kage(KageFontType font = KAGEFONT_MINCHO, double size = 0,
+            std::shared_ptr<SymbolTable> symbols = nullptr);
+        Kage(Kage const&)            = delete;
+        Kage& operator=(Kage const&) = delete;
+
+        std::shared_ptr<SymbolTable> GetSymbolTable();
 
         void SetBuhin(std::string name, std::vector<Stroke> data);
         void SetBuhin(std::string name, std::string data);
         void PushBuhin(std::string name, std::vector<Stroke> data);
         void PushBuhin(std::string name, std::string data);
         std::vector<Stroke> SearchBuhin(std::string name);
+        std::vector<std::string> GetDependents(std::string name);
+        std::vector<std::string> TakeDirtyGlyphs();
 
         void                SetFont(KageFontType type, double size = 0);
+        std::shared_ptr<KageFont> GetFont();
         void                SetDBsearchCallback(DBsearchCallbackFunc callback);
+        void SetDBbatchSearchCallback(DBbatchSearchCallbackFunc callback);
+        void SetDBsearchCache(std::shared_ptr<DBsearchCache> cache);
+        std::future<size_t> PrefetchBuhin(std::vector<std::string> names);
         void                SetNotDefGlyph(std::vector<Stroke> glyph);
+        void                SetRenderCache(std::shared_ptr<RenderCache> cache);
         void                MakeGlyph(Canva& canva, std::string buhin);
         void                MakeGlyph2(Canva& canva, std::vector<Stroke> data);
+        // 直接输出到sink，不经过中间的Canva（使用渲染缓存时除外）
+        void MakeGlyph(PathSink& sink, std::string buhin);
+        void MakeGlyph2(PathSink& sink, std::vector<Stroke> data);
         std::vector<Stroke> ExtractGlyph(std::string buhin);
         std::vector<Stroke> ExtractGlyph2(std::vector<Stroke> data);
         CheckGlyphState     CheckGlyph(std::string buhin);
         CheckGlyphState     CheckGlyph2(std::vector<Stroke> data);
+        CheckReport         CheckAllGlyphs(size_t threads = 0);
+        uint64_t            GetGlyphHash(std::string buhin);
+        uint64_t            GetGlyphHash2(std::vector<Stroke> data);
+        // 按展开后各种笔画的数目与引用的层数估计生成的相对开销（权重见
+        // schedule.h），不绘制也不变换笔画，用于安排批量生成的顺序
+        double              EstimateCost(std::string buhin);
+        double              EstimateCost2(std::vector<Stroke> data);
     };
 
 } // namespace Kage
@@ -1,13 +1,30 @@
 #ifndef _KAGEFONT_H
 #define _KAGEFONT_H
 
+#include <functional>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #include "canva.h"
 #include "gwdata.h"
+#include "lru.h"
+#include "pathsink.h"
 
 namespace Kage {
 
+    // 笔画轮廓与部件实例记忆的默认容量，按轮廓点数计
+    // 每个点连同键与索引约占40字节，默认容量下每个字体实例至多约20MB
+    const size_t STROKE_MEMO_CAPACITY   = 1 << 18;
+    const size_t INSTANCE_MEMO_CAPACITY = 1 << 18;
+    // 记忆按键的哈希值分为几份，各自加锁并平分容量
+    const size_t MEMO_SHARDS = 16;
+
+    // 字形中由同一个引用部件展开的笔画[begin, end)
+    typedef struct {
+        size_t begin, end;
+    } StrokeGroup;
+
     typedef enum {
         KAGEFONT_DEFAULT,
         KAGEFONT_MINCHO,
@@ -19,12 +36,58 @@ namespace Kage {
         KageFontType _type = KAGEFONT_DEFAULT;
         double       _size;
 
+        typedef struct OutlineMemoShard {
+            std::mutex                                  mutex;
+            LruCache<std::string, std::vector<Contour>> entries;
+            size_t                                      hits = 0, misses = 0;
+        } OutlineMemoShard;
+
+        typedef struct OutlineMemo {
+            OutlineMemoShard shards[MEMO_SHARDS];
+        } OutlineMemo;
+
+        // 字体参数由实例固定，故键中只含笔画（与调整值）
+        // _strokeMemo保存单个笔画的轮廓，_instanceMemo保存整个部件的轮廓
+        OutlineMemo _strokeMemo, _instanceMemo;
+
+        // 以strokes中除第index个以外的笔画为参照，绘制第index个笔画
+        virtual void DrawStrokeInGlyph(
+            Canva& cv, std::vector<Stroke> const& strokes, size_t index) = 0;
+        // [begin, end)以外的笔画是否都不影响其中笔画的绘制
+        virtual bool IsIsolated(
+            std::vector<Stroke> const& strokes, size_t begin, size_t end) = 0;
+
+        static std::string StrokeMemoKey(Stroke const& s);
+        static void        StrokeMemoKeyAppend(std::string& key, double v);
+        static void   SetMemoCapacity(OutlineMemo& memo, size_t capacity);
+        static size_t MemoHits(OutlineMemo& memo);
+        static size_t MemoMisses(OutlineMemo& memo);
+        void DrawMemoized(Canva& cv, OutlineMemo& memo, std::string const& key,
+            std::function<void(Canva&)> const& draw);
+        void DrawStrokes(Canva& cv, std::vector<Stroke> const& strokes,
+            std::vector<StrokeGroup> const& groups);
+
     public:
         KageFont(double size = 0);
-        virtual ~KageFont()                                  = default;
-        virtual Canva DrawGlyph(std::vector<Stroke> strokes) = 0;
+        virtual ~KageFont() = default;
+
+        // groups按起点排列且互不重叠，不影响结果，只用于复用部件的轮廓
+        Canva DrawGlyph(std::vector<Stroke> strokes,
+            std::vector<StrokeGroup> const& groups = {});
+        void  DrawGlyph(std::vector<Stroke> strokes, PathSink& sink,
+             std::vector<StrokeGroup> const& groups = {});
 
         KageFontType GetType();
+        double       GetSize();
+
+        // 容量为0时不记忆；多个线程使用同一实例时，只有键落在同一份中的
+        // 查找才互相等待
+        void   SetStrokeMemoCapacity(size_t capacity);
+        size_t StrokeMemoHits();
+        size_t StrokeMemoMisses();
+        void   SetInstanceMemoCapacity(size_t capacity);
+        size_t InstanceMemoHits();
+        size_t InstanceMemoMisses();
     };
 
 } // namespace Kage
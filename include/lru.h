@@ -0,0 +1,87 @@
+#ifndef _LRU_H
+#define _LRU_H
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace Kage {
+
+    // 按总开销（如字节数）限制容量的LRU缓存，不加锁，由使用者保证线程安全
+    template<typename K, typename V, typename H = std::hash<K>>
+    class LruCache {
+        typedef struct {
+            K      key;
+            V      value;
+            size_t cost;
+        } Entry;
+
+        std::list<Entry>                                            _list;
+        std::unordered_map<K, typename std::list<Entry>::iterator, H> _map;
+        size_t _capacity, _cost = 0;
+
+        void Evict() {
+            while(_cost > _capacity && !_list.empty()) {
+                _cost -= _list.back().cost;
+                _map.erase(_list.back().key);
+                _list.pop_back();
+            }
+        }
+
+    public:
+        LruCache(size_t capacity = 0) {
+            _capacity = capacity;
+        }
+
+        // 命中时移到最前
+        V* Get(const K& key) {
+            auto it = _map.find(key);
+            if(it == _map.end()) return nullptr;
+            _list.splice(_list.begin(), _list, it->second);
+            return &it->second->value;
+        }
+
+        // 开销超过容量的条目不会被存入
+        void Put(const K& key, V value, size_t cost) {
+            Erase(key);
+            if(cost > _capacity) return;
+            _list.push_front({key, std::move(value), cost});
+            _map[key]  = _list.begin();
+            _cost     += cost;
+            Evict();
+        }
+
+        bool Erase(const K& key) {
+            auto it = _map.find(key);
+            if(it == _map.end()) return false;
+            _cost -= it->second->cost;
+            _list.erase(it->second);
+            _map.erase(it);
+            return true;
+        }
+
+        void Clear() {
+            _list.clear(), _map.clear(), _cost = 0;
+        }
+
+        void SetCapacity(size_t capacity) {
+            _capacity = capacity;
+            Evict();
+        }
+
+        size_t Capacity() {
+            return _capacity;
+        }
+
+        size_t Cost() {
+            return _cost;
+        }
+
+        size_t Size() {
+            return _list.size();
+        }
+    };
+
+} // namespace Kage
+
+#endif
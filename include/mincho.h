@@ -20,6 +20,12 @@ namespace Kage {
 
     typedef struct std::array<Point, 2> PointArray2;
 
+    // 由其他笔画决定的调整值，笔画未用到的项为0
+    typedef struct {
+        double uroko, uroko2, tate, hane, kakato, mage;
+        bool   kirikuchi;
+    } MinchoAdjustment;
+
     class Mincho: public KageFont {
         double kRate = 50;
         // 基本粗细参数
@@ -38,17 +44,31 @@ namespace Kage {
         double kAdjustTateStep, kAdjustMageStep, kMinWidthYY, kMinWidthT_adjust,
             kMinWidthC;
 
+        void DrawStrokeInGlyph(
+            Canva& cv, std::vector<Stroke> const& strokes, size_t index);
+        bool IsIsolated(
+            std::vector<Stroke> const& strokes, size_t begin, size_t end);
         void DrawAdjustedStroke(
-            Canva& cv, Stroke s, std::vector<Stroke> others);
+            Canva& cv, Stroke s, std::vector<Stroke> const& others);
+        void DrawStroke(Canva& cv, Stroke s, MinchoAdjustment const& adj);
 
-        double AdjustUrokoParam(Stroke stroke, std::vector<Stroke> others);
-        double AdjustUroko2Param(Stroke stroke, std::vector<Stroke> others);
-        double AdjustTateParam(Stroke stroke, std::vector<Stroke> others);
+        MinchoAdjustment GetAdjustment(
+            Stroke s, std::vector<Stroke> const& others);
+        void GetAdjustmentZones(Stroke s, std::vector<BoundingData>& zones);
+        double AdjustUrokoParam(
+            Stroke stroke, std::vector<Stroke> const& others);
+        double AdjustUroko2Param(
+            Stroke stroke, std::vector<Stroke> const& others);
+        double AdjustTateParam(
+            Stroke stroke, std::vector<Stroke> const& others);
         double AdjustHaneParam(
-            Stroke stroke, Point ep, std::vector<Stroke> others);
-        double AdjustKakatoParam(Stroke stroke, std::vector<Stroke> others);
-        bool   AdjustKirikuchiParam(Stroke stroke, std::vector<Stroke> others);
-        double AdjustMageParam(Stroke stroke, std::vector<Stroke> others);
+            Stroke stroke, Point ep, std::vector<Stroke> const& others);
+        double AdjustKakatoParam(
+            Stroke stroke, std::vector<Stroke> const& others);
+        bool AdjustKirikuchiParam(
+            Stroke stroke, std::vector<Stroke> const& others);
+        double AdjustMageParam(
+            Stroke stroke, std::vector<Stroke> const& others);
 
         Contour GetStartOfVLine(
             Point p1, Point p2, StartType a1, double kMinWidthT, Canva& cv);
@@ -63,7 +83,6 @@ namespace Kage {
     public:
         Mincho(double size = 0);
         ~Mincho() = default;
-        Canva DrawGlyph(std::vector<Stroke> strokes);
     };
 
 } // namespace Kage
@@ -0,0 +1,24 @@
+#ifndef _OVERLAP_H
+#define _OVERLAP_H
+
+#include <vector>
+
+#include "contour.h"
+#include "point.h"
+
+namespace Kage {
+
+    // 曲线展开为折线时允许的最大误差（字面坐标系为200x200）
+    const double OVERLAP_FLATTEN_TOLERANCE = 0.01;
+
+    // 合并所有轮廓，返回互不重叠的轮廓：填充的轮廓面积为正，洞为负且标记
+    // 为洞（Contour::SetHole）；输入中未标记的轮廓不论方向均视为填充，标记
+    // 的洞从其外轮廓中扣除，因此合并的结果可与其他轮廓再次合并
+    // 曲线段在结果中按原曲线的参数区间截取，不重新拟合
+    // 若计算失败则返回输入的轮廓，只按上述规则统一方向
+    std::vector<Contour> RemoveOverlap(std::vector<Contour> contours,
+        double tolerance = OVERLAP_FLATTEN_TOLERANCE);
+
+} // namespace Kage
+
+#endif
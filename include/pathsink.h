@@ -0,0 +1,43 @@
+#ifndef _PATHSINK_H
+#define _PATHSINK_H
+
+#include "contour.h"
+#include "point.h"
+
+namespace Kage {
+
+    class Canva;
+
+    // 轮廓的输出接口，字形可直接绘制到其中而不经过中间的Canva
+    // 每个轮廓以MoveTo开始、Close结束，所有轮廓均为闭合的
+    class PathSink {
+    public:
+        virtual ~PathSink() = default;
+
+        virtual void MoveTo(Point p)                       = 0;
+        virtual void LineTo(Point p)                       = 0;
+        virtual void QuadTo(Point p1, Point p2)            = 0;
+        virtual void CubicTo(Point p1, Point p2, Point p3) = 0;
+        virtual void Close()                               = 0;
+    };
+
+    // 将轮廓追加到Canva中
+    class CanvaSink: public PathSink {
+        Canva&  _canva;
+        Contour _contour;
+
+    public:
+        CanvaSink(Canva& canva);
+
+        void MoveTo(Point p);
+        void LineTo(Point p);
+        void QuadTo(Point p1, Point p2);
+        void CubicTo(Point p1, Point p2, Point p3);
+        void Close();
+    };
+
+    void Contour2Sink(Contour& contour, PathSink& sink);
+
+} // namespace Kage
+
+#endif
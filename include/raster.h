@@ -0,0 +1,46 @@
+#ifndef _RASTER_H
+#define _RASTER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "pathsink.h"
+#include "point.h"
+
+namespace Kage {
+
+    // 每个像素在竖直方向上的采样数
+    const int RASTER_SUBSAMPLES = 4;
+
+    typedef struct {
+        double x0, y0, x1, y1;
+        int    winding;
+    } RasterEdge;
+
+    // 按nonzero规则填充的灰度光栅化，字形坐标乘以scale后为像素坐标
+    // 曲线在输入时即展开为折线，不保存轮廓
+    class RasterSink: public PathSink {
+        size_t                  _width, _height;
+        double                  _scale;
+        std::vector<RasterEdge> _edges; // 像素坐标
+        Point                   _start, _last;
+
+        void Edge(Point p);
+
+    public:
+        RasterSink(size_t width, size_t height, double scale = 1);
+
+        void MoveTo(Point p);
+        void LineTo(Point p);
+        void QuadTo(Point p1, Point p2);
+        void CubicTo(Point p1, Point p2, Point p3);
+        void Close();
+
+        void Clear();
+        // 按行排列的覆盖率，0为空白，255为完全覆盖
+        std::vector<uint8_t> Pixels();
+    };
+
+} // namespace Kage
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef _SCHEDULE_H
+#define _SCHEDULE_H
+
+#include <cstddef>
+#include <vector>
+
+#include "gwdata.h"
+
+namespace Kage {
+
+    // 估计生成开销所用的权重，约为不使用记忆时明朝体绘制的微秒数
+    // 只用于排序与分配，不必精确；按KageMicroBench的Mincho/*结果取整
+    const double COST_STROKE[8] = {
+        0,   // STROKE_SPECIAL
+        1,   // STROKE_STRAIGHT
+        200, // STROKE_CURVE
+        330, // STROKE_BENDING
+        540, // STROKE_BENDING_ROUND
+        0,   // 未使用
+        630, // STROKE_BEZIER
+        380  // STROKE_VCURVE
+    };
+    const double COST_HOOK      = 200; // 带钩的收笔（竖钩、弯钩）需要拟合曲线
+    const double COST_REFERENCE = 10;  // 每次查询与变换引用的部件
+    const double COST_DEPTH     = 20;  // 引用的每一层嵌套
+    const double COST_GLYPH     = 20;  // 每个字形固定的开销
+
+    double EstimateStrokeCost(Stroke const& stroke);
+
+    // 最长的任务优先：将下标按每block个（为0时不分块）分块，块内按开销
+    // 从大到小排列，开销相同时保持原顺序；分块使按顺序输出时缓冲的结果有界
+    std::vector<size_t> ScheduleLongestFirst(
+        std::vector<double> const& costs, size_t block = 0);
+
+    // 将各任务分配到parts份，使各份开销的总和接近（LPT贪心），返回每个任务
+    // 所在的份；只由costs决定，因此在不同进程中得到相同的结果
+    std::vector<size_t> PartitionByCost(
+        std::vector<double> const& costs, size_t parts);
+
+} // namespace Kage
+
+#endif
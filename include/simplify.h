@@ -0,0 +1,20 @@
+#ifndef _SIMPLIFY_H
+#define _SIMPLIFY_H
+
+#include "contour.h"
+#include "point.h"
+
+namespace Kage {
+
+    // 简化轮廓时允许的最大偏差（字面坐标系为200x200）
+    const double SIMPLIFY_TOLERANCE = 0.05;
+
+    // 简化轮廓：去除重合点与退化段，合并近似共线的直线段，
+    // 在误差范围内合并相邻的三次曲线，最后对齐到网格（grid为0时不对齐）
+    // 若简化后轮廓退化则原样返回
+    Contour SimplifyContour(Contour contour,
+        double tolerance = SIMPLIFY_TOLERANCE, double grid = 0);
+
+} // namespace Kage
+
+#endif
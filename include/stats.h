@@ -0,0 +1,90 @@
+#ifndef _STATS_H
+#define _STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "gwdata.h"
+
+namespace Kage {
+
+    // 各处理阶段，耗时与内存分配均包含其中嵌套的阶段
+    typedef enum {
+        STATS_GLYPH,        // 整个字形的生成
+        STATS_PARSE,        // 笔画数据的解析
+        STATS_RESOLVE,      // 部件的查找（含查询回调）
+        STATS_TRANSFORM,    // 引用部件的包围盒、拉伸与坐标变换
+        STATS_ADJUST,       // 明朝体笔画间的调整
+        STATS_CURVE_SAMPLE, // 曲线的采样
+        STATS_CURVE_FIT,    // 曲线的拟合
+        STATS_CANVA,        // 画布的Push与翻转、旋转
+        STATS_EXPORT,       // 导出为SVG、SFD等格式
+        STATS_STAGE_COUNT
+    } StatsStage;
+
+    // 笔画种类、起笔与收笔种类的计数范围，超出的计入最后一项
+    const int STATS_TYPE_SLOTS = 512;
+
+    typedef struct {
+        uint64_t calls[STATS_STAGE_COUNT];
+        uint64_t nanos[STATS_STAGE_COUNT];
+        // 阶段内的内存分配次数与字节数，仅在定义KAGE_ENABLE_ALLOC_STATS时统计
+        uint64_t allocs[STATS_STAGE_COUNT];
+        uint64_t allocBytes[STATS_STAGE_COUNT];
+        // 绘制的笔画按种类计数，只含非零项
+        std::map<int, uint64_t> strokeTypes, startTypes, endTypes;
+    } KageStats;
+
+    // 未定义KAGE_ENABLE_STATS时不做任何统计，以下函数返回全零的结果
+    KageStats   GetStats();       // 所有线程的合计
+    KageStats   GetThreadStats(); // 仅当前线程，用于分析单个字形
+    void        ResetStats();
+    const char* StatsStageName(StatsStage stage);
+    std::string FormatStats(KageStats const& stats);
+
+    // 当前线程自启动以来经operator new分配的次数与字节数
+    // 未定义KAGE_ENABLE_ALLOC_STATS时均为0
+    void StatsAllocCounters(uint64_t& allocs, uint64_t& bytes);
+
+    void StatsAdd(StatsStage stage, uint64_t nanos, uint64_t allocs = 0,
+        uint64_t allocBytes = 0);
+    void StatsCountStroke(Stroke const& stroke);
+
+    // 在作用域结束时记录一次调用及其耗时
+    class StatsScope {
+        StatsStage                            _stage;
+        std::chrono::steady_clock::time_point _begin;
+        uint64_t                              _allocs, _allocBytes;
+
+    public:
+        StatsScope(StatsStage stage) {
+            _stage = stage;
+            StatsAllocCounters(_allocs, _allocBytes);
+            _begin = std::chrono::steady_clock::now();
+        }
+        ~StatsScope() {
+            auto     end = std::chrono::steady_clock::now();
+            uint64_t allocs, allocBytes;
+            StatsAllocCounters(allocs, allocBytes);
+            StatsAdd(_stage,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    end - _begin)
+                    .count(),
+                allocs - _allocs, allocBytes - _allocBytes);
+        }
+    };
+
+#ifdef KAGE_ENABLE_STATS
+#    define KAGE_STATS_SCOPE(stage) ::Kage::StatsScope _kageStatsScope(stage)
+#    define KAGE_STATS_STROKE(stroke) ::Kage::StatsCountStroke(stroke)
+#else
+#    define KAGE_STATS_SCOPE(stage) ((void)0)
+#    define KAGE_STATS_STROKE(stroke) ((void)0)
+#endif
+
+} // namespace Kage
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef _SYMBOL_H
+#define _SYMBOL_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Kage {
+
+    // 部件名与32位编号的对应表，编号从0开始连续分配，0为空字符串
+    // 编号只在同一个表内有效，不可跨进程使用
+    class SymbolTable {
+        std::mutex                                _mutex;
+        std::deque<std::string>                   _names;
+        std::unordered_map<std::string, uint32_t> _ids;
+
+    public:
+        SymbolTable();
+
+        uint32_t    Intern(std::string name);
+        bool        Find(std::string name, uint32_t& id);
+        std::string Name(uint32_t id);
+        size_t      Size();
+    };
+
+    // 进程内默认的表，未指定时StrokesParse与Kage均使用此表
+    std::shared_ptr<SymbolTable> DefaultSymbolTable();
+
+} // namespace Kage
+
+#endif
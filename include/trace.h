@@ -0,0 +1,82 @@
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace Kage {
+
+    // 时间线记录，输出为Chrome trace格式，可用chrome://tracing或Perfetto查看
+    // 未定义KAGE_ENABLE_TRACE时以下宏不产生任何代码；定义后也只在
+    // StartTrace与StopTrace之间记录
+    const size_t TRACE_BUFFER_EVENTS = 1 << 16; // 每个线程保留的最近事件数
+    const size_t TRACE_ARG_SIZE      = 40;      // 事件参数的最大长度，超出截断
+
+    typedef struct {
+        const char* name;       // 须为静态字符串
+        uint64_t    begin, end; // 纳秒，自StartTrace起
+        char        arg[TRACE_ARG_SIZE];
+    } TraceEvent;
+
+    // 每个线程各自的环形缓冲区，满后覆盖最早的事件
+    void     StartTrace(size_t eventsPerThread = TRACE_BUFFER_EVENTS);
+    void     StopTrace();
+    bool     TraceActive();
+    void     TraceThreadName(std::string name); // 时间线上显示的线程名
+    uint64_t TraceNow();
+    void TraceRecord(const char* name, uint64_t begin, std::string const& arg);
+    // 须在StopTrace之后、所有渲染线程结束当前调用后调用，返回写出的事件数
+    size_t WriteChromeTrace(std::ostream& out);
+
+    // 在作用域结束时记录一个完整事件
+    class TraceScope {
+        const char* _name;
+        uint64_t    _begin;
+        bool        _active;
+        std::string _arg;
+
+    public:
+        TraceScope(const char* name) {
+            _name = name, _active = TraceActive();
+            if(_active) _begin = TraceNow();
+        }
+        ~TraceScope() {
+            if(_active) TraceRecord(_name, _begin, _arg);
+        }
+
+        bool Active() {
+            return _active;
+        }
+
+        void SetArg(std::string arg) {
+            _arg = arg;
+        }
+    };
+
+    // 只在锁已被占用时记录等待的时间，用于观察锁竞争
+    template<typename Lock> void TraceLock(Lock& lock, const char* name) {
+#ifdef KAGE_ENABLE_TRACE
+        if(lock.try_lock()) return;
+        TraceScope scope(name);
+#else
+        (void)name;
+#endif
+        lock.lock();
+    }
+
+#ifdef KAGE_ENABLE_TRACE
+#    define KAGE_TRACE_SCOPE(name) ::Kage::TraceScope _kageTraceScope(name)
+// 参数只在记录时才求值
+#    define KAGE_TRACE_SCOPE_ARG(name, arg)               \
+        ::Kage::TraceScope _kageTraceScope(name);         \
+        if(_kageTraceScope.Active()) _kageTraceScope.SetArg(arg)
+#else
+#    define KAGE_TRACE_SCOPE(name) ((void)0)
+#    define KAGE_TRACE_SCOPE_ARG(name, arg) ((void)0)
+#endif
+
+} // namespace Kage
+
+#endif
@@ -0,0 +1,70 @@
+#include <random>
+
+#include "synthetic.h"
+
+namespace KageBench {
+
+    // 没有数据转储时使用的合成字库：固定种子，结构接近GlyphWiki
+    // 基本部件由常见笔画组成，中间部件与字形按左右、上下、包围引用它们
+    // 只使用mt19937的原始输出，保证各平台生成相同的数据
+    std::vector<std::string> SyntheticCorpus(Kage::Kage& kage, size_t glyphs) {
+        std::mt19937 rng(20240601);
+        auto         R = [&](int lo, int hi) -> int {
+            return lo + (int)(rng() % (unsigned)(hi - lo + 1));
+        };
+        auto S = [](int v) { return std::to_string(v); };
+        const char* kinds[] = {"1:0:0", "1:2:2", "1:0:2", "1:0:13", "1:12:13",
+            "1:0:4", "1:0:24", "1:32:32", "2:7:8", "2:32:7", "2:0:7", "2:7:4",
+            "3:0:5", "3:22:5", "4:0:5", "6:7:8", "7:32:7"};
+        const char* places[] = {"0:0:100:200", "90:0:200:200", "0:0:200:100",
+            "0:90:200:200", "0:0:200:200", "30:40:170:190", "0:0:70:200",
+            "60:0:200:200"};
+        std::vector<std::string> names;
+
+        for(int i = 0; i < 300; i++) {
+            std::string data;
+            int         n = R(2, 10);
+            for(int j = 0; j < n; j++) {
+                std::string kind = kinds[R(0, 16)];
+                if(!data.empty()) data += "$";
+                data += kind;
+                int x1 = R(15, 185), y1 = R(15, 185);
+                if(kind[0] == '1' && (kind == "1:0:0" || kind == "1:2:2" ||
+                                         kind == "1:0:2" || kind == "1:32:32"))
+                    data += ":" + S(x1) + ":" + S(y1) + ":" +
+                        S(R(x1, 190)) + ":" + S(y1 + R(-4, 4)); // 横
+                else if(kind[0] == '1')
+                    data += ":" + S(x1) + ":" + S(R(10, 100)) + ":" + S(x1) +
+                        ":" + S(R(110, 190)); // 竖
+                else {
+                    int points = kind[0] == '6' || kind[0] == '7' ? 4 : 3;
+                    for(int k = 0; k < points; k++)
+                        data += ":" + S(R(10, 190)) + ":" + S(R(10, 190));
+                }
+            }
+            names.push_back("c" + S(i));
+            kage.SetBuhin(names.back(), data);
+        }
+        for(int i = 0; i < 2000; i++) {
+            int         p    = R(0, 3) * 2;
+            std::string data = std::string("99:0:0:") + places[p] + ":c" +
+                S(R(0, 299)) + "$99:0:0:" + places[p + 1] + ":c" + S(R(0, 299));
+            names.push_back("m" + S(i));
+            kage.SetBuhin(names.back(), data);
+        }
+        for(size_t i = 0; i < glyphs; i++) {
+            int         p    = R(0, 3) * 2;
+            std::string data = std::string("99:0:0:") + places[p] + ":m" +
+                S(R(0, 1999)) + "$99:0:0:" + places[p + 1] + ":" +
+                (R(0, 1) ? "m" + S(R(0, 1999)) : "c" + S(R(0, 299)));
+            if(R(0, 9) == 0) // 带拉伸参数的引用
+                data += "$99:" + S(R(0, 200)) + ":" + S(R(0, 200)) +
+                    ":0:0:200:200:c" + S(R(0, 299)) + ":0:" + S(R(0, 200)) +
+                    ":" + S(R(0, 200));
+            names.push_back("g" + S(i));
+            kage.SetBuhin(names.back(), data);
+        }
+        return names;
+    }
+
+} // namespace KageBench
@@ -0,0 +1,16 @@
+#ifndef _SYNTHETIC_H
+#define _SYNTHETIC_H
+
+#include <string>
+#include <vector>
+
+#include "kage.h"
+
+namespace KageBench {
+
+    // 以固定种子生成合成字库并载入kage，返回glyphs个顶层字形的名称
+    std::vector<std::string> SyntheticCorpus(Kage::Kage& kage, size_t glyphs);
+
+} // namespace KageBench
+
+#endif
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#    include <sys/resource.h>
+#endif
+
+#include "dump.h"
+#include "export.h"
+#include "kage.h"
+#include "stats.h"
+#include "synthetic.h"
+#include "trace.h"
+
+// 整个字库规模的吞吐量与单字延迟测试
+// 用法：KageCorpusBench [--dump file] [--synthetic N] [--threads 1,2,4]
+//       [--export none|svg|sfd] [--top N] [--stats] [--trace file]
+// --stats需以KAGE_ENABLE_STATS构建，输出每种字体全部测量的各阶段合计
+// --trace需以KAGE_ENABLE_TRACE构建，将全部测量的时间线写入file
+// 以KAGE_ENABLE_ALLOC_STATS构建时另外输出每个字形的内存分配次数
+
+typedef struct {
+    std::string name;
+    double      ms;
+    uint64_t    allocs, allocBytes; // 生成（及导出）该字形期间的分配
+} GlyphTime;
+
+// 进程的峰值常驻内存（KB），不支持的平台返回0
+long PeakRSS() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#    ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#    else
+    return usage.ru_maxrss;
+#    endif
+#endif
+}
+
+int main(int argc, char** argv) {
+    std::string         dump, exportType = "none", trace;
+    size_t              synthetic = 5000, top = 10;
+    bool                stats = false;
+    std::vector<size_t> threadCounts;
+    for(int i = 1; i < argc; i++) {
+        if(!std::strcmp(argv[i], "--dump") && i + 1 < argc)
+            dump = argv[++i];
+        else if(!std::strcmp(argv[i], "--synthetic") && i + 1 < argc)
+            synthetic = std::strtoul(argv[++i], nullptr, 10);
+        else if(!std::strcmp(argv[i], "--threads") && i + 1 < argc) {
+            std::stringstream ss(argv[++i]);
+            std::string       item;
+            while(std::getline(ss, item, ','))
+                threadCounts.push_back(
+                    std::max((size_t)1, (size_t)std::stoul(item)));
+        } else if(!std::strcmp(argv[i], "--export") && i + 1 < argc)
+            exportType = argv[++i];
+        else if(!std::strcmp(argv[i], "--top") && i + 1 < argc)
+            top = std::strtoul(argv[++i], nullptr, 10);
+        else if(!std::strcmp(argv[i], "--stats"))
+            stats = true;
+        else if(!std::strcmp(argv[i], "--trace") && i + 1 < argc)
+            trace = argv[++i];
+        else {
+            std::fprintf(stderr,
+                "usage: %s [--dump file] [--synthetic N] [--threads 1,2,4] "
+                "[--export none|svg|sfd] [--top N] [--stats] [--trace file]\n",
+                argv[0]);
+            return 1;
+        }
+    }
+    if(threadCounts.empty()) {
+        size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+        for(size_t i = 1; i < hardware; i *= 2) threadCounts.push_back(i);
+        threadCounts.push_back(hardware);
+    }
+
+    Kage::Kage               kage;
+    std::vector<std::string> names;
+    auto                     tic = std::chrono::steady_clock::now();
+    if(!dump.empty()) {
+        std::ifstream in(dump);
+        if(!in) {
+            std::fprintf(stderr, "cannot open %s\n", dump.c_str());
+            return 1;
+        }
+        Kage::LoadGlyphWikiDump(kage, in, &names);
+    } else
+        names = KageBench::SyntheticCorpus(kage, synthetic);
+    auto toc = std::chrono::steady_clock::now();
+    std::printf("loaded %zu glyphs from %s in %.1f ms, peak RSS %ld KB\n",
+        names.size(), dump.empty() ? "synthetic corpus" : dump.c_str(),
+        std::chrono::duration<double, std::milli>(toc - tic).count(),
+        PeakRSS());
+
+    std::printf("%-7s %7s %12s %8s %9s %9s %9s %9s %12s\n", "font", "threads",
+        "glyphs/s", "speedup", "p50(ms)", "p95(ms)", "p99(ms)", "max(ms)",
+        "peakRSS(KB)");
+    if(!trace.empty()) Kage::StartTrace();
+    for(auto type: {Kage::KAGEFONT_MINCHO, Kage::KAGEFONT_GOTHIC}) {
+        const char* font = type == Kage::KAGEFONT_MINCHO ? "Mincho" : "Gothic";
+        double      base = 0;
+        std::vector<GlyphTime> slowest;
+        Kage::ResetStats();
+        for(auto threads: threadCounts) {
+            kage.SetFont(type); // 每次从空的记忆开始
+            std::vector<std::vector<GlyphTime>> times(threads);
+            std::atomic<size_t>                 next(0);
+            auto worker = [&](size_t id) {
+                Kage::TraceThreadName("worker " + std::to_string(id));
+                size_t i;
+                while((i = next++) < names.size()) {
+                    uint64_t allocs, allocBytes, allocsEnd, allocBytesEnd;
+                    Kage::StatsAllocCounters(allocs, allocBytes);
+                    auto        begin = std::chrono::steady_clock::now();
+                    Kage::Canva canva;
+                    kage.MakeGlyph(canva, names[i]);
+                    if(exportType == "svg")
+                        Kage::Canva2SVG(canva);
+                    else if(exportType == "sfd")
+                        Kage::Canva2SFD(canva);
+                    auto end = std::chrono::steady_clock::now();
+                    Kage::StatsAllocCounters(allocsEnd, allocBytesEnd);
+                    times[id].push_back({names[i],
+                        std::chrono::duration<double, std::milli>(end - begin)
+                            .count(),
+                        allocsEnd - allocs, allocBytesEnd - allocBytes});
+                }
+            };
+            tic = std::chrono::steady_clock::now();
+            std::vector<std::thread> pool;
+            for(size_t i = 0; i < threads; i++) pool.emplace_back(worker, i);
+            for(auto& i: pool) i.join();
+            toc = std::chrono::steady_clock::now();
+
+            std::vector<GlyphTime> all;
+            for(auto& i: times) all.insert(all.end(), i.begin(), i.end());
+            std::sort(all.begin(), all.end(),
+                [](GlyphTime const& a, GlyphTime const& b) {
+                    return a.ms > b.ms;
+                });
+            auto percentile = [&](double p) {
+                if(all.empty()) return 0.0;
+                return all[std::min(all.size() - 1,
+                               (size_t)((1 - p) * all.size()))]
+                    .ms;
+            };
+            double seconds = std::chrono::duration<double>(toc - tic).count();
+            double rate    = names.size() / seconds;
+            if(base == 0) base = rate;
+            std::printf("%-7s %7zu %12.1f %8.2f %9.3f %9.3f %9.3f %9.3f %12ld\n",
+                font, threads, rate, rate / base, percentile(0.5),
+                percentile(0.95), percentile(0.99),
+                all.empty() ? 0 : all[0].ms, PeakRSS());
+#ifdef KAGE_ENABLE_ALLOC_STATS
+            uint64_t         allocs = 0, allocBytes = 0;
+            GlyphTime const* most   = nullptr;
+            for(auto& i: all) {
+                allocs += i.allocs, allocBytes += i.allocBytes;
+                if(!most || i.allocs > most->allocs) most = &i;
+            }
+            if(most)
+                std::printf("  allocations per glyph: mean %.1f (%.1f KB), "
+                            "max %llu in %s\n",
+                    (double)allocs / all.size(),
+                    allocBytes / 1024.0 / all.size(),
+                    (unsigned long long)most->allocs, most->name.c_str());
+#endif
+            std::fflush(stdout);
+            if(threads == threadCounts.front())
+                slowest.assign(
+                    all.begin(), all.begin() + std::min(top, all.size()));
+        }
+        if(stats)
+            std::printf("%s", Kage::FormatStats(Kage::GetStats()).c_str());
+        // 单线程（或最少线程）测量中最慢的字形
+        for(auto& i: slowest) {
+            std::printf("  slowest %-24s %9.3f ms %5zu strokes", i.name.c_str(),
+                i.ms, kage.ExtractGlyph(i.name).size());
+#ifdef KAGE_ENABLE_ALLOC_STATS
+            std::printf(" %8llu allocs", (unsigned long long)i.allocs);
+#endif
+            std::printf("\n");
+        }
+    }
+    if(!trace.empty()) {
+        Kage::StopTrace();
+        std::ofstream out(trace);
+        size_t        events = Kage::WriteChromeTrace(out);
+        std::printf("wrote %zu trace events to %s\n", events, trace.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include "kage.h"
+
+namespace KageBench {
+
+    // 将被测操作连续执行iterations次
+    typedef std::function<void(size_t iterations)> BenchFunc;
+
+    void Register(std::string name, BenchFunc func);
+
+    // 使结果对编译器可见，避免被测代码被优化掉
+    void Escape(const void* p);
+    template<typename T> void DoNotOptimize(T const& value) {
+        Escape(&value);
+    }
+
+    // 载入inputs.h中的全部部件
+    void LoadInputs(Kage::Kage& kage);
+
+    void RegisterParseBenchmarks();
+    void RegisterFontBenchmarks();
+    void RegisterCurveBenchmarks();
+    void RegisterCanvaBenchmarks();
+
+} // namespace KageBench
+
+#endif
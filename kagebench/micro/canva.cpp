@@ -0,0 +1,56 @@
+#include "bench.h"
+#include "export.h"
+
+namespace KageBench {
+
+    // 画布操作与导出
+    void RegisterCanvaBenchmarks() {
+        Kage::Contour contour;
+        contour.MoveTo(Kage::Point(20, 20));
+        contour.LineTo(Kage::Point(180, 20));
+        contour.QuadraticTo(Kage::Point(190, 100), Kage::Point(180, 180));
+        contour.LineTo(Kage::Point(20, 180));
+        Register("Canva::Push", [=](size_t n) {
+            Kage::Canva canva;
+            for(size_t i = 0; i < n; i++) canva.Push(contour);
+            DoNotOptimize(canva);
+        });
+        Register("Canva::DrawLine", [=](size_t n) {
+            Kage::Canva canva;
+            for(size_t i = 0; i < n; i++)
+                canva.DrawLine(Kage::Point(20, 30), Kage::Point(180, 40), 3);
+            DoNotOptimize(canva);
+        });
+
+        Kage::Kage kage;
+        LoadInputs(kage);
+        Kage::Canva glyph;
+        kage.MakeGlyph(glyph, "test");
+        const Kage::Point p1(0, 0), p2(200, 200);
+        std::vector<std::pair<std::string, void (Kage::Canva::*)(
+                                               Kage::Point, Kage::Point)>>
+            transforms = {{"FlipLR", &Kage::Canva::FlipLR},
+                {"FlipUD", &Kage::Canva::FlipUD},
+                {"Rotate90", &Kage::Canva::Rotate90},
+                {"Rotate180", &Kage::Canva::Rotate180},
+                {"Rotate270", &Kage::Canva::Rotate270}};
+        for(auto& i: transforms) {
+            auto transform = i.second;
+            Register("Canva::" + i.first, [=](size_t n) {
+                auto canva = glyph;
+                for(size_t j = 0; j < n; j++) (canva.*transform)(p1, p2);
+                DoNotOptimize(canva);
+            });
+        }
+
+        Register("Canva2SVG/test", [=](size_t n) {
+            for(size_t i = 0; i < n; i++)
+                DoNotOptimize(Kage::Canva2SVG(glyph));
+        });
+        Register("Canva2SFD/test", [=](size_t n) {
+            for(size_t i = 0; i < n; i++)
+                DoNotOptimize(Kage::Canva2SFD(glyph));
+        });
+    }
+
+} // namespace KageBench
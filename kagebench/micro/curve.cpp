@@ -0,0 +1,41 @@
+#include "bench.h"
+#include "bezier.h"
+#include "fitcurve.h"
+
+namespace KageBench {
+
+    // 曲线采样与拟合
+    void RegisterCurveBenchmarks() {
+        Kage::Point p1(30, 130), c1(27, 167), c2(20, 180), p2(11, 187);
+        auto width   = [](double t) -> double { return 3 + 2 * t; };
+        auto width_d = [](double) -> double { return 2; };
+        Register("qBezier", [=](size_t n) {
+            for(size_t i = 0; i < n; i++) {
+                std::vector<Kage::CubicSpline> bez1, bez2;
+                Kage::qBezier(p1, c1, p2, width, width_d, bez1, bez2);
+                DoNotOptimize(bez1), DoNotOptimize(bez2);
+            }
+        });
+        Register("cBezier", [=](size_t n) {
+            for(size_t i = 0; i < n; i++) {
+                std::vector<Kage::CubicSpline> bez1, bez2;
+                Kage::cBezier(p1, c1, c2, p2, width, width_d, bez1, bez2);
+                DoNotOptimize(bez1), DoNotOptimize(bez2);
+            }
+        });
+
+        // 与qBezier中相同的采样：二次曲线的一侧轮廓
+        std::vector<Kage::Point> points;
+        for(int i = 0; i <= Kage::BEZIER_STEPS; i++) {
+            double t = (double)i / Kage::BEZIER_STEPS, s = 1 - t;
+            Kage::Point xy = p1 * (s * s) + c1 * (2 * s * t) + p2 * (t * t),
+                        d  = (c1 - p1) * (2 * s) + (p2 - c1) * (2 * t);
+            points.push_back(xy - d.UnitNormalVector() * width(t));
+        }
+        Register("FitCurve", [=](size_t n) {
+            for(size_t i = 0; i < n; i++)
+                DoNotOptimize(Kage::FitCurve(points, 0.1));
+        });
+    }
+
+} // namespace KageBench
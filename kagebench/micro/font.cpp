@@ -0,0 +1,58 @@
+#include <memory>
+
+#include "bench.h"
+#include "gothic.h"
+#include "inputs.h"
+#include "mincho.h"
+
+namespace KageBench {
+
+    // 每种笔画单独绘制；关闭记忆以测量实际的绘制开销
+    void RegisterFontBenchmarks() {
+        auto kage = std::make_shared<Kage::Kage>();
+        LoadInputs(*kage);
+        const auto glyphs = {"test", "u6f22"};
+
+        std::vector<std::pair<std::string, std::shared_ptr<Kage::KageFont>>>
+            fonts = {{"Mincho", std::make_shared<Kage::Mincho>()},
+                {"Gothic", std::make_shared<Kage::Gothic>()}};
+        for(auto& font: fonts) {
+            auto cold = font.second;
+            cold->SetStrokeMemoCapacity(0);
+            cold->SetInstanceMemoCapacity(0);
+            for(auto& i: STROKE_INPUTS) {
+                const auto strokes = Kage::StrokesParse(i.data);
+                Register(font.first + "/" + i.name, [=](size_t n) {
+                    for(size_t j = 0; j < n; j++)
+                        DoNotOptimize(cold->DrawGlyph(strokes));
+                });
+            }
+            for(auto name: glyphs) {
+                const auto strokes = kage->ExtractGlyph(name);
+                Register(font.first + "/Glyph/" + name, [=](size_t n) {
+                    for(size_t j = 0; j < n; j++)
+                        DoNotOptimize(cold->DrawGlyph(strokes));
+                });
+            }
+        }
+
+        // 整个流程，含部件展开与记忆的命中
+        for(auto type: {Kage::KAGEFONT_MINCHO, Kage::KAGEFONT_GOTHIC}) {
+            auto warm = std::make_shared<Kage::Kage>(type);
+            LoadInputs(*warm);
+            std::string font =
+                type == Kage::KAGEFONT_MINCHO ? "Mincho" : "Gothic";
+            for(auto name: glyphs) {
+                std::string buhin = name;
+                Register("MakeGlyph/" + font + "/" + buhin, [=](size_t n) {
+                    for(size_t j = 0; j < n; j++) {
+                        Kage::Canva canva;
+                        warm->MakeGlyph(canva, buhin);
+                        DoNotOptimize(canva);
+                    }
+                });
+            }
+        }
+    }
+
+} // namespace KageBench
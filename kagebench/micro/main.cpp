@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "bench.h"
+#include "inputs.h"
+#include "stats.h"
+
+namespace KageBench {
+
+    typedef struct {
+        std::string name;
+        BenchFunc   func;
+    } BenchEntry;
+
+    std::vector<BenchEntry>& Registry() {
+        static std::vector<BenchEntry> registry;
+        return registry;
+    }
+
+    void Register(std::string name, BenchFunc func) {
+        Registry().push_back({name, func});
+    }
+
+    const void* volatile escaped;
+
+    void Escape(const void* p) {
+        escaped = p;
+    }
+
+    void LoadInputs(Kage::Kage& kage) {
+        for(auto& i: BUHIN_INPUTS) kage.PushBuhin(i.name, i.data);
+    }
+
+    // 迭代次数逐步增加，直到单次测量不少于minTime
+    // allocs为最后一次测量中每次迭代的平均分配次数
+    double Measure(BenchFunc const& func, double minTime, size_t& iterations,
+        double& allocs) {
+        func(1); // 预热
+        iterations = 1;
+        while(true) {
+            uint64_t before, after, bytes;
+            Kage::StatsAllocCounters(before, bytes);
+            auto tic = std::chrono::steady_clock::now();
+            func(iterations);
+            auto toc = std::chrono::steady_clock::now();
+            Kage::StatsAllocCounters(after, bytes);
+            double elapsed =
+                std::chrono::duration<double, std::milli>(toc - tic).count();
+            if(elapsed >= minTime || iterations >= ((size_t)1 << 30)) {
+                allocs = (double)(after - before) / iterations;
+                return elapsed * 1e6 / iterations;
+            }
+            double scale = elapsed <= 0 ? 100 : minTime * 1.2 / elapsed;
+            iterations   = std::max(iterations + 1,
+                  (size_t)(iterations * std::min(scale, 100.0)));
+        }
+    }
+
+} // namespace KageBench
+
+#ifdef KAGE_ENABLE_ALLOC_STATS
+const bool ALLOC_COLUMN = true;
+#else
+const bool ALLOC_COLUMN = false;
+#endif
+
+int main(int argc, char** argv) {
+    std::string filter;
+    double      minTime = 200; // 毫秒
+    bool        list    = false;
+    for(int i = 1; i < argc; i++) {
+        if(!std::strcmp(argv[i], "--filter") && i + 1 < argc)
+            filter = argv[++i];
+        else if(!std::strcmp(argv[i], "--min-time") && i + 1 < argc)
+            minTime = std::atof(argv[++i]);
+        else if(!std::strcmp(argv[i], "--list"))
+            list = true;
+        else {
+            std::fprintf(stderr,
+                "usage: %s [--filter substring] [--min-time ms] [--list]\n",
+                argv[0]);
+            return 1;
+        }
+    }
+
+    KageBench::RegisterParseBenchmarks();
+    KageBench::RegisterFontBenchmarks();
+    KageBench::RegisterCurveBenchmarks();
+    KageBench::RegisterCanvaBenchmarks();
+
+    if(!list)
+        std::printf("%-44s %12s %14s%s\n", "benchmark", "iterations", "ns/op",
+            ALLOC_COLUMN ? "   allocs/op" : "");
+    for(auto& i: KageBench::Registry()) {
+        if(i.name.find(filter) == std::string::npos) continue;
+        if(list) {
+            std::printf("%s\n", i.name.c_str());
+            continue;
+        }
+        size_t iterations;
+        double allocs;
+        double ns = KageBench::Measure(i.func, minTime, iterations, allocs);
+        std::printf("%-44s %12zu %14.1f", i.name.c_str(), iterations, ns);
+        if(ALLOC_COLUMN) std::printf(" %12.1f", allocs);
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+#include "bench.h"
+#include "inputs.h"
+
+namespace KageBench {
+
+    // 解析、序列化与部件展开
+    void RegisterParseBenchmarks() {
+        const std::string data = BUHIN_INPUTS[0].data;
+        Register("StrokesParse/test", [=](size_t n) {
+            for(size_t i = 0; i < n; i++)
+                DoNotOptimize(Kage::StrokesParse(data));
+        });
+        const auto strokes = Kage::StrokesParse(data);
+        Register("StrokesToString/test", [=](size_t n) {
+            for(size_t i = 0; i < n; i++)
+                DoNotOptimize(Kage::StrokesToString(strokes));
+        });
+
+        auto kage = std::make_shared<Kage::Kage>();
+        LoadInputs(*kage);
+        for(auto name: {"test", "u6f22"}) {
+            std::string buhin = name;
+            Register("ExtractGlyph/" + buhin, [=](size_t n) {
+                for(size_t i = 0; i < n; i++)
+                    DoNotOptimize(kage->ExtractGlyph(buhin));
+            });
+        }
+    }
+
+} // namespace KageBench
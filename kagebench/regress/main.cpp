@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "binary.h"
+#include "kage.h"
+#include "synthetic.h"
+
+// 输出等价性与性能的回归检查，任何一项失败时返回1
+// 用法：KageRegress [--golden file] [--baseline file] [--tolerance 0.05]
+//       [--max-slowdown 0.1] [--repeat 5] [--update]
+// 轮廓与golden中保存的逐字比较，偏差超过tolerance（字形单位，全宽200）或者
+// 轮廓的方向与洞的标记不同即失败；编码与golden不同的字形均逐一列出
+// 每个字形的生成耗时取repeat次中的最小值，各字体的合计比baseline慢
+// max-slowdown以上即失败
+// baseline不存在时以本次结果创建；--update以本次结果重写golden与baseline
+
+const size_t REGRESS_GLYPHS     = 40;  // 合成字库中参与比较的字形数
+const size_t REGRESS_COMPONENTS = 20;  // 另外单独比较的基本部件数
+const double REGRESS_FLATTEN    = 0.5; // 展开折线时的最大段长
+
+typedef struct {
+    std::string font, name, binary;
+} RegressEntry;
+
+// 将轮廓展开为折线，直线也按段长细分，以便按顶点计算偏差
+class RegressFlattenSink: public Kage::PathSink {
+    Kage::Point _last;
+
+    void Add(Kage::Point p) {
+        polylines.back().push_back(p);
+        _last = p;
+    }
+
+    size_t Segments(double length) {
+        return std::max((size_t)1, (size_t)std::ceil(length / REGRESS_FLATTEN));
+    }
+
+public:
+    std::vector<std::vector<Kage::Point>> polylines;
+
+    void MoveTo(Kage::Point p) {
+        polylines.push_back({});
+        Add(p);
+    }
+
+    void LineTo(Kage::Point p) {
+        Kage::Point p0 = _last;
+        size_t      n  = Segments((p - p0).GetLength());
+        for(size_t i = 1; i <= n; i++)
+            Add(p0 + (p - p0) * ((double)i / n));
+    }
+
+    void QuadTo(Kage::Point p1, Kage::Point p2) {
+        Kage::Point p0 = _last;
+        size_t      n =
+            Segments((p1 - p0).GetLength() + (p2 - p1).GetLength());
+        for(size_t i = 1; i <= n; i++) {
+            double t = (double)i / n, s = 1 - t;
+            Add(p0 * (s * s) + p1 * (2 * s * t) + p2 * (t * t));
+        }
+    }
+
+    void CubicTo(Kage::Point p1, Kage::Point p2, Kage::Point p3) {
+        Kage::Point p0 = _last;
+        size_t      n  = Segments((p1 - p0).GetLength() +
+             (p2 - p1).GetLength() + (p3 - p2).GetLength());
+        for(size_t i = 1; i <= n; i++) {
+            double t = (double)i / n, s = 1 - t;
+            Add(p0 * (s * s * s) + p1 * (3 * s * s * t) +
+                p2 * (3 * s * t * t) + p3 * (t * t * t));
+        }
+    }
+
+    void Close() {
+        if(!polylines.empty() && !polylines.back().empty())
+            LineTo(polylines.back().front());
+    }
+};
+
+// 线段按包围盒放入均匀网格，只查询limit范围内的格子
+class RegressSegmentGrid {
+    typedef struct {
+        Kage::Point a, b;
+    } Segment;
+
+    std::vector<Segment>                               _segments;
+    std::map<std::pair<int, int>, std::vector<size_t>> _cells;
+    double                                             _cell;
+
+    int Cell(double v) {
+        return (int)std::floor(v / _cell);
+    }
+
+public:
+    RegressSegmentGrid(
+        std::vector<std::vector<Kage::Point>> const& polylines, double cell) {
+        _cell = cell;
+        for(auto& i: polylines)
+            for(size_t j = 1; j < i.size(); j++) {
+                Segment s = {i[j - 1], i[j]};
+                for(int x = Cell(std::min(s.a.x, s.b.x));
+                    x <= Cell(std::max(s.a.x, s.b.x)); x++)
+                    for(int y = Cell(std::min(s.a.y, s.b.y));
+                        y <= Cell(std::max(s.a.y, s.b.y)); y++)
+                        _cells[{x, y}].push_back(_segments.size());
+                _segments.push_back(s);
+            }
+    }
+
+    // 到最近线段的距离，超过limit时返回limit
+    double Distance(Kage::Point p, double limit) {
+        double best = limit;
+        for(int x = Cell(p.x - limit); x <= Cell(p.x + limit); x++)
+            for(int y = Cell(p.y - limit); y <= Cell(p.y + limit); y++) {
+                auto it = _cells.find({x, y});
+                if(it == _cells.end()) continue;
+                for(auto i: it->second) {
+                    Kage::Point a = _segments[i].a, d = _segments[i].b - a;
+                    double      len2 = d.Dot(d);
+                    double      t = len2 > 0 ? (p - a).Dot(d) / len2 : 0;
+                    t             = std::min(1.0, std::max(0.0, t));
+                    best = std::min(best, (p - (a + d * t)).GetLength());
+                }
+            }
+        return best;
+    }
+};
+
+// 两个轮廓之间的对称Hausdorff距离，超过limit时返回limit
+double RegressDeviation(Kage::Canva a, Kage::Canva b, double limit) {
+    RegressFlattenSink sa, sb;
+    a.Replay(sa), b.Replay(sb);
+    if(sa.polylines.empty() != sb.polylines.empty()) return limit;
+    RegressSegmentGrid ga(sa.polylines, 4), gb(sb.polylines, 4);
+    double             deviation = 0;
+    for(auto& i: sa.polylines)
+        for(auto& j: i) deviation = std::max(deviation, gb.Distance(j, limit));
+    for(auto& i: sb.polylines)
+        for(auto& j: i) deviation = std::max(deviation, ga.Distance(j, limit));
+    return deviation;
+}
+
+// 逐个轮廓比较方向与洞的标记，Hausdorff距离无法区分方向相反的轮廓
+// 面积不超过minArea的轮廓方向不稳定，不比较其方向
+bool RegressSameOrientation(Kage::Canva a, Kage::Canva b, double minArea) {
+    auto ca = a.Contours(), cb = b.Contours();
+    if(ca.size() != cb.size()) return false;
+    for(size_t i = 0; i < ca.size(); i++) {
+        double sa = ca[i].SignedArea(), sb = cb[i].SignedArea();
+        if(ca[i].isHole() != cb[i].isHole()) return false;
+        if(std::abs(sa) > minArea && std::abs(sb) > minArea &&
+            (sa < 0) != (sb < 0))
+            return false;
+    }
+    return true;
+}
+
+// golden文件：首行"KageRegress 1"，之后每项为"字体 名称 字节数"一行
+// 紧接Canva2Binary的输出与一个换行
+bool RegressReadGolden(std::string path, std::vector<RegressEntry>& entries) {
+    std::ifstream in(path, std::ios::binary);
+    std::string   line;
+    if(!std::getline(in, line) || line != "KageRegress 1") return false;
+    while(std::getline(in, line)) {
+        std::stringstream ss(line);
+        RegressEntry      entry;
+        size_t            size;
+        if(!(ss >> entry.font >> entry.name >> size)) return false;
+        entry.binary.resize(size);
+        if(!in.read(&entry.binary[0], size) || in.get() != '\n') return false;
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+bool RegressWriteGolden(
+    std::string path, std::vector<RegressEntry> const& entries) {
+    std::ofstream out(path, std::ios::binary);
+    out << "KageRegress 1\n";
+    for(auto& i: entries)
+        out << i.font << " " << i.name << " " << i.binary.size() << "\n"
+            << i.binary << "\n";
+    return (bool)out;
+}
+
+// baseline文件：每行"字体 毫秒"
+std::map<std::string, double> RegressReadBaseline(std::string path) {
+    std::map<std::string, double> baseline;
+    std::ifstream                 in(path);
+    std::string                   font;
+    double                        ms;
+    while(in >> font >> ms) baseline[font] = ms;
+    return baseline;
+}
+
+bool RegressWriteBaseline(
+    std::string path, std::map<std::string, double> const& baseline) {
+    std::ofstream out(path);
+    char          line[64];
+    for(auto& i: baseline) {
+        std::snprintf(line, sizeof(line), "%.3f", i.second);
+        out << i.first << " " << line << "\n";
+    }
+    return (bool)out;
+}
+
+int main(int argc, char** argv) {
+    std::string golden = "golden.kgo", baselinePath = "regress_baseline.txt";
+    double      tolerance = 0.05, maxSlowdown = 0.1;
+    size_t      repeat = 5;
+    bool        update = false;
+    for(int i = 1; i < argc; i++) {
+        if(!std::strcmp(argv[i], "--golden") && i + 1 < argc)
+            golden = argv[++i];
+        else if(!std::strcmp(argv[i], "--baseline") && i + 1 < argc)
+            baselinePath = argv[++i];
+        else if(!std::strcmp(argv[i], "--tolerance") && i + 1 < argc)
+            tolerance = std::atof(argv[++i]);
+        else if(!std::strcmp(argv[i], "--max-slowdown") && i + 1 < argc)
+            maxSlowdown = std::atof(argv[++i]);
+        else if(!std::strcmp(argv[i], "--repeat") && i + 1 < argc)
+            repeat = std::max((size_t)1,
+                (size_t)std::strtoul(argv[++i], nullptr, 10));
+        else if(!std::strcmp(argv[i], "--update"))
+            update = true;
+        else {
+            std::fprintf(stderr,
+                "usage: %s [--golden file] [--baseline file] "
+                "[--tolerance 0.05] [--max-slowdown 0.1] [--repeat 5] "
+                "[--update]\n",
+                argv[0]);
+            return 1;
+        }
+    }
+
+    Kage::Kage               kage;
+    std::vector<std::string> names =
+        KageBench::SyntheticCorpus(kage, REGRESS_GLYPHS);
+    // 只保留前几个基本部件与全部顶层字形
+    names.erase(names.begin() + REGRESS_COMPONENTS,
+        names.end() - REGRESS_GLYPHS);
+
+    std::vector<RegressEntry>     entries;
+    std::map<std::string, double> timing;
+    for(auto type: {Kage::KAGEFONT_MINCHO, Kage::KAGEFONT_GOTHIC}) {
+        std::string font = type == Kage::KAGEFONT_MINCHO ? "Mincho" : "Gothic";
+        std::vector<double> best(names.size(), INFINITY);
+        for(size_t r = 0; r < repeat; r++) {
+            kage.SetFont(type); // 每次从空的记忆开始
+            for(size_t i = 0; i < names.size(); i++) {
+                auto        tic = std::chrono::steady_clock::now();
+                Kage::Canva canva;
+                kage.MakeGlyph(canva, names[i]);
+                auto   toc = std::chrono::steady_clock::now();
+                double ms =
+                    std::chrono::duration<double, std::milli>(toc - tic).count();
+                best[i] = std::min(best[i], ms);
+                if(r == 0)
+                    entries.push_back(
+                        {font, names[i], Kage::Canva2Binary(canva)});
+            }
+        }
+        // 逐字取最小值再求和，减少其他进程的干扰
+        timing[font] = 0;
+        for(auto i: best) timing[font] += i;
+    }
+
+    if(update) {
+        if(!RegressWriteGolden(golden, entries) ||
+            !RegressWriteBaseline(baselinePath, timing)) {
+            std::fprintf(stderr, "cannot write %s or %s\n", golden.c_str(),
+                baselinePath.c_str());
+            return 1;
+        }
+        std::printf("wrote %zu outlines to %s and timings to %s\n",
+            entries.size(), golden.c_str(), baselinePath.c_str());
+        return 0;
+    }
+
+    bool                      pass = true;
+    std::vector<RegressEntry> expected;
+    if(!RegressReadGolden(golden, expected)) {
+        std::fprintf(stderr, "cannot read %s (run with --update to create)\n",
+            golden.c_str());
+        return 1;
+    }
+    std::map<std::pair<std::string, std::string>, std::string> current;
+    for(auto& i: entries) current[{i.font, i.name}] = i.binary;
+    size_t changed = 0, differ = 0;
+    double worst = 0;
+    double limit  = std::max(tolerance * 10, 1.0);
+    for(auto& i: expected) {
+        auto it = current.find({i.font, i.name});
+        if(it == current.end()) {
+            std::printf("  missing %s %s\n", i.font.c_str(), i.name.c_str());
+            pass = false;
+            continue;
+        }
+        if(it->second == i.binary) continue; // 量化后完全相同
+        Kage::Canva a, b;
+        double      deviation = limit;
+        bool        oriented  = false;
+        if(Kage::CanvaView(i.binary).ToCanva(a) &&
+            Kage::CanvaView(it->second).ToCanva(b)) {
+            deviation = RegressDeviation(a, b, limit);
+            oriented  = RegressSameOrientation(a, b, tolerance * tolerance);
+        }
+        worst    = std::max(worst, deviation);
+        bool bad = deviation > tolerance || !oriented;
+        std::printf("  %s %s %s by %s%.3f%s\n", bad ? "differs" : "changed",
+            i.font.c_str(), i.name.c_str(), deviation >= limit ? ">" : "",
+            deviation, oriented ? "" : ", orientation or holes differ");
+        changed++;
+        if(bad) differ++, pass = false;
+    }
+    std::printf("outlines: %zu compared, %zu changed, %zu differ, "
+                "max deviation %.4f (tolerance %.4f)\n",
+        expected.size(), changed, differ, worst, tolerance);
+
+    auto baseline = RegressReadBaseline(baselinePath);
+    if(baseline.empty()) {
+        RegressWriteBaseline(baselinePath, timing);
+        std::printf("no baseline, recorded current timings to %s\n",
+            baselinePath.c_str());
+    } else {
+        for(auto& i: timing) {
+            auto it = baseline.find(i.first);
+            if(it == baseline.end()) continue;
+            double change = i.second / it->second - 1;
+            bool   slow   = change > maxSlowdown;
+            std::printf("%-7s %10.3f ms, baseline %10.3f ms, %+6.1f%% %s\n",
+                i.first.c_str(), i.second, it->second, change * 100,
+                slow ? "SLOWER" : "ok");
+            if(slow) pass = false;
+        }
+    }
+    std::printf("%s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#    include <fcntl.h>
+#    include <io.h>
+#    include <windows.h>
+#endif
+
+#include "binary.h"
+#include "kage.h"
+#include "options.h"
+#include "schedule.h"
+#include "shard.h"
+#include "stats.h"
+
+// 批量生成字形的命令行工具
+// 用法：kage-render --dump file [--dump file ...] [--font mincho|gothic]
+//       [--weight name|number] [--format svg|compact-svg|sfd|binary]
+//       [--threads N] [--schedule cost|input]
+//       [--output file | --output-dir dir] [--stats]
+//       [--shard i/K [--partition hash|range|cost]] [name ...]
+//       kage-render --merge [--format ...] [--output ... | --output-dir ...]
+//       shard ...
+// 未给出字形名时从标准输入逐行读取；输出顺序与输入相同
+// 默认按估计的开销从大到小生成（每RENDER_WINDOW个为一块），避免开销大的
+// 字形排在最后、只剩一个线程在工作；--schedule input按输入顺序生成
+// 输出到文件或标准输出时，每个字形为"名称 字节数"一行，紧接数据与一个换行
+// 输出到目录时每个字形一个文件，名称中的'/'与'\'替换为'_'
+// 部件数据中找不到的字形输出为缺字符号并报告到标准错误，此时返回2
+// --shard只生成第i个分片中的字形，输出为分片文件（见shard.h），各分片
+// 须使用相同的字形名列表与部件数据；--merge将全部K个分片合并为最终的输出
+
+const size_t RENDER_WINDOW = 1024; // 已生成而未写出的字形约在两块以内
+
+std::string RenderFileName(std::string name, std::string const& format) {
+    for(auto& c: name)
+        if(c == '/' || c == '\\') c = '_';
+    if(format == "sfd") return name + ".sfd";
+    if(format == "binary") return name + ".kgo";
+    return name + ".svg";
+}
+
+// 输出到目录时每个字形一个文件，否则写入out
+bool RenderWrite(std::ostream* out, std::string const& outputDir,
+    std::string const& name, std::string const& format,
+    std::string const& result) {
+    if(outputDir.empty()) {
+        *out << name << " " << result.size() << "\n" << result << "\n";
+        return true;
+    }
+    std::string   path = outputDir + "/" + RenderFileName(name, format);
+    std::ofstream glyph(path, std::ios::binary);
+    if(glyph << result) return true;
+    std::fprintf(stderr, "cannot write %s\n", path.c_str());
+    return false;
+}
+
+// 每个分片按位置排列，因此每次只需读入各分片的下一个字形
+// 分片不完整或不属于同一次生成时返回false
+bool RenderMerge(std::vector<std::string> const& paths,
+    std::string const& format, std::ostream* out, std::string const& outputDir,
+    size_t& missed, bool& failed) {
+    std::vector<std::unique_ptr<RenderShardReader>> shards;
+    for(auto& i: paths) {
+        shards.emplace_back(new RenderShardReader());
+        if(!shards.back()->Open(i)) return false;
+    }
+    size_t            total = shards[0]->total, count = shards[0]->count;
+    std::vector<char> seen(count);
+    for(auto& i: shards) {
+        if(i->total != total || i->count != count || seen[i->index]) {
+            std::fprintf(stderr, "shards are not from the same build\n");
+            return false;
+        }
+        seen[i->index] = 1;
+    }
+    if(shards.size() != count) {
+        std::fprintf(stderr, "expected %zu shards, got %zu\n", count,
+            shards.size());
+        return false;
+    }
+
+    std::vector<RenderShardEntry> heads(shards.size());
+    std::vector<char>             valid(shards.size());
+    for(size_t i = 0; i < shards.size(); i++)
+        valid[i] = shards[i]->Next(heads[i]);
+    for(size_t next = 0; next < total; next++) {
+        size_t i = 0;
+        while(i < shards.size() && !(valid[i] && heads[i].index == next)) i++;
+        if(i == shards.size()) {
+            std::fprintf(
+                stderr, "glyph %zu is missing from the shards\n", next);
+            return false;
+        }
+        Kage::Canva canva;
+        if(!Kage::CanvaView(heads[i].data).ToCanva(canva)) {
+            std::fprintf(stderr, "%s: invalid outline of %s\n",
+                paths[i].c_str(), heads[i].name.c_str());
+            return false;
+        }
+        if(heads[i].missing) {
+            std::fprintf(stderr, "missing %s\n", heads[i].name.c_str());
+            missed++;
+        }
+        failed |= !RenderWrite(
+            out, outputDir, heads[i].name, format, RenderExport(canva, format));
+        valid[i] = shards[i]->Next(heads[i]);
+    }
+    for(size_t i = 0; i < shards.size(); i++)
+        if(valid[i] || shards[i]->Failed()) {
+            std::fprintf(stderr, "%s: unexpected data\n", paths[i].c_str());
+            return false;
+        }
+    return true;
+}
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    setlocale(LC_ALL, ".utf-8");
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    std::vector<std::string> dumps, names;
+    std::string              format = "svg", output, outputDir;
+    std::string              schedule = "cost", partition = "hash";
+    Kage::KageFontType       font   = Kage::KAGEFONT_MINCHO;
+    double                   weight = 0;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t shardIndex = 0, shardCount = 0; // shardCount为0时不分片
+    bool   stats = false, merge = false, usage = false;
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool        value = i + 1 < argc;
+        if(arg == "--dump" && value)
+            dumps.push_back(argv[++i]);
+        else if(arg == "--font" && value)
+            usage |= !RenderParseFont(argv[++i], font);
+        else if(arg == "--weight" && value)
+            usage |= !RenderParseWeight(argv[++i], weight);
+        else if(arg == "--format" && value) {
+            format = argv[++i];
+            usage |= !RenderValidFormat(format);
+        } else if(arg == "--schedule" && value) {
+            schedule = argv[++i];
+            usage |= schedule != "cost" && schedule != "input";
+        } else if(arg == "--threads" && value)
+            threads = std::max((size_t)1,
+                (size_t)std::strtoul(argv[++i], nullptr, 10));
+        else if(arg == "--output" && value)
+            output = argv[++i];
+        else if(arg == "--output-dir" && value)
+            outputDir = argv[++i];
+        else if(arg == "--stats")
+            stats = true;
+        else if(arg == "--shard" && value)
+            usage |= !RenderParseShard(argv[++i], shardIndex, shardCount);
+        else if(arg == "--partition" && value) {
+            partition = argv[++i];
+            usage |= !RenderValidPartition(partition);
+        } else if(arg == "--merge")
+            merge = true;
+        else if(arg.compare(0, 2, "--") == 0)
+            usage = true;
+        else
+            names.push_back(arg);
+    }
+    if(merge)
+        usage |= names.empty() || shardCount > 0;
+    else
+        usage |= dumps.empty() || (shardCount > 0 && !outputDir.empty());
+    if(usage || (!output.empty() && !outputDir.empty())) {
+        std::fprintf(stderr,
+            "usage: %s --dump file [--dump file ...] [--font mincho|gothic]\n"
+            "       [--weight hairline|extralight|light|regular|medium|"
+            "demibold|number]\n"
+            "       [--format svg|compact-svg|sfd|binary] [--threads N]\n"
+            "       [--schedule cost|input]\n"
+            "       [--output file | --output-dir dir] [--stats]\n"
+            "       [--shard i/K [--partition hash|range|cost]] [name ...]\n"
+            "       %s --merge [--format ...] "
+            "[--output file | --output-dir dir] shard ...\n",
+            argv[0], argv[0]);
+        return 1;
+    }
+
+    std::ofstream file;
+    std::ostream* out = &std::cout;
+    if(!output.empty()) {
+        file.open(output, std::ios::binary);
+        if(!file) {
+            std::fprintf(stderr, "cannot open %s\n", output.c_str());
+            return 1;
+        }
+        out = &file;
+    }
+#ifdef _WIN32
+    else if(outputDir.empty())
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    size_t missed = 0;
+    bool   failed = false;
+    if(merge) {
+        if(!RenderMerge(names, format, out, outputDir, missed, failed))
+            return 1;
+        out->flush();
+        if(outputDir.empty() && !*out) {
+            std::fprintf(stderr, "cannot write output\n");
+            failed = true;
+        }
+        return failed ? 1 : missed ? 2 : 0;
+    }
+
+    auto       tic = std::chrono::steady_clock::now();
+    Kage::Kage kage(font, weight);
+    if(!RenderLoadDumps(kage, dumps)) return 1;
+    if(names.empty()) {
+        std::string line;
+        while(std::getline(std::cin, line)) {
+            while(!line.empty() && (line.back() == '\r' || line.back() == ' '))
+                line.pop_back();
+            if(!line.empty()) names.push_back(line);
+        }
+    }
+    std::vector<size_t> positions; // 分片时各字形在完整列表中的位置
+    if(shardCount > 0) {
+        auto part = RenderPartition(names, partition, shardCount, kage);
+        std::vector<std::string> selected;
+        for(size_t i = 0; i < names.size(); i++)
+            if(part[i] == shardIndex)
+                positions.push_back(i), selected.push_back(names[i]);
+        *out << RenderShardHeader(names.size(), shardCount, shardIndex);
+        names.swap(selected);
+    }
+    std::vector<double> costs(names.size());
+    if(schedule == "cost")
+        for(size_t i = 0; i < names.size(); i++)
+            costs[i] = kage.EstimateCost(names[i]);
+    auto order  = Kage::ScheduleLongestFirst(costs, RENDER_WINDOW);
+    auto loaded = std::chrono::steady_clock::now();
+
+    // 工作线程按order领取字形，主线程按编号顺序写出
+    std::vector<std::string> results(names.size());
+    std::vector<char>        done(names.size()), missing(names.size());
+    std::mutex               mutex;
+    std::condition_variable  ready, space;
+    size_t                   next = 0, written = 0;
+    auto                     worker = [&]() {
+        while(true) {
+            std::unique_lock<std::mutex> lock(mutex);
+            space.wait(lock, [&] {
+                return next >= names.size() ||
+                    order[next] / RENDER_WINDOW <= written / RENDER_WINDOW + 1;
+            });
+            if(next >= names.size()) return;
+            size_t i = order[next++];
+            lock.unlock();
+
+            Kage::Canva canva;
+            auto        data = kage.SearchBuhin(names[i]);
+            if(data.empty())
+                kage.MakeGlyph(canva, names[i]); // 缺字符号
+            else
+                kage.MakeGlyph2(canva, data);
+            // 分片中保存不量化的轮廓，合并后的输出因此与不分片时相同
+            std::string result = shardCount > 0
+                ? Kage::Canva2Binary(canva, 0)
+                : RenderExport(canva, format);
+
+            lock.lock();
+            results[i] = std::move(result);
+            done[i] = 1, missing[i] = data.empty();
+            if(i == written) ready.notify_one();
+        }
+    };
+    std::vector<std::thread> pool;
+    for(size_t i = 0; i < std::min(threads, names.size()); i++)
+        pool.emplace_back(worker);
+
+    while(written < names.size()) {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [&] { return done[written] != 0; });
+        std::string result = std::move(results[written]);
+        size_t      i      = written++;
+        space.notify_all();
+        lock.unlock();
+
+        if(missing[i]) {
+            std::fprintf(stderr, "missing %s\n", names[i].c_str());
+            missed++;
+        }
+        if(shardCount > 0) {
+            RenderShardEntry entry = {
+                positions[i], names[i], missing[i] != 0, std::move(result)};
+            RenderWriteShardEntry(*out, entry);
+        } else
+            failed |= !RenderWrite(out, outputDir, names[i], format, result);
+    }
+    for(auto& i: pool) i.join();
+    out->flush();
+    if(outputDir.empty() && !*out) {
+        std::fprintf(stderr, "cannot write output\n");
+        failed = true;
+    }
+
+    if(stats) {
+        auto   toc     = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(toc - loaded).count();
+        std::fprintf(stderr,
+            "loaded in %.1f ms, rendered %zu glyphs (%zu missing) on %zu "
+            "threads in %.1f ms, %.1f glyphs/s\n",
+            std::chrono::duration<double, std::milli>(loaded - tic).count(),
+            names.size(), missed, std::min(threads, names.size()),
+            seconds * 1e3, seconds > 0 ? names.size() / seconds : 0.0);
+        std::fprintf(stderr, "%s", Kage::FormatStats(Kage::GetStats()).c_str());
+    }
+    return failed ? 1 : missed ? 2 : 0;
+}
@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include "binary.h"
+#include "dump.h"
+#include "export.h"
+#include "mincho.h"
+#include "options.h"
+
+const RenderWeight RENDER_WEIGHTS[6] = {{"hairline", HAIR_LINE},
+    {"extralight", EXTRA_LIGHT}, {"light", LIGHT}, {"regular", 0},
+    {"medium", MEDIUM}, {"demibold", DEMIBOLD}};
+
+bool RenderParseWeight(std::string text, double& size) {
+    for(auto& i: RENDER_WEIGHTS)
+        if(text == i.name) {
+            size = i.size;
+            return true;
+        }
+    char* end;
+    size = std::strtod(text.c_str(), &end);
+    return !text.empty() && *end == 0;
+}
+
+bool RenderParseFont(std::string text, Kage::KageFontType& font) {
+    if(text == "mincho")
+        font = Kage::KAGEFONT_MINCHO;
+    else if(text == "gothic")
+        font = Kage::KAGEFONT_GOTHIC;
+    else
+        return false;
+    return true;
+}
+
+bool RenderValidFormat(std::string const& format) {
+    return format == "svg" || format == "compact-svg" || format == "sfd" ||
+        format == "binary";
+}
+
+std::string RenderExport(Kage::Canva& canva, std::string const& format) {
+    if(format == "svg") return Kage::Canva2SVG(canva);
+    if(format == "compact-svg") return Kage::Canva2CompactSVG(canva);
+    if(format == "sfd") return Kage::Canva2SFD(canva);
+    return Kage::Canva2Binary(canva);
+}
+
+bool RenderLoadDumps(Kage::Kage& kage, std::vector<std::string> const& dumps) {
+    for(auto& i: dumps) {
+        std::ifstream in(i);
+        if(!in) {
+            std::fprintf(stderr, "cannot open %s\n", i.c_str());
+            return false;
+        }
+        Kage::LoadGlyphWikiDump(kage, in);
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+#ifndef _OPTIONS_H
+#define _OPTIONS_H
+
+#include <string>
+#include <vector>
+
+#include "canva.h"
+#include "kage.h"
+
+// kage-render与kage-server共用的参数解析与输出
+
+typedef struct {
+    const char* name;
+    double      size;
+} RenderWeight;
+
+// 明朝体的粗细名称与Kage构造函数的size参数的对应
+extern const RenderWeight RENDER_WEIGHTS[6];
+
+bool RenderParseWeight(std::string text, double& size); // 名称或数值
+bool RenderParseFont(std::string text, Kage::KageFontType& font);
+bool RenderValidFormat(std::string const& format);
+
+// svg、compact-svg、sfd或binary
+std::string RenderExport(Kage::Canva& canva, std::string const& format);
+
+// 依次读入GlyphWiki的数据转储，无法打开时报告到标准错误并返回false
+bool RenderLoadDumps(Kage::Kage& kage, std::vector<std::string> const& dumps);
+
+#endif
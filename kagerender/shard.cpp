@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#include "schedule.h"
+#include "shard.h"
+
+bool RenderParseShard(std::string text, size_t& index, size_t& count) {
+    char*         end;
+    unsigned long i = std::strtoul(text.c_str(), &end, 10);
+    if(end == text.c_str() || *end != '/') return false;
+    const char*   rest = end + 1;
+    unsigned long k    = std::strtoul(rest, &end, 10);
+    if(end == rest || *end != 0 || k == 0 || i >= k) return false;
+    index = i, count = k;
+    return true;
+}
+
+bool RenderValidPartition(std::string const& partition) {
+    return partition == "hash" || partition == "range" || partition == "cost";
+}
+
+uint64_t RenderNameHash(std::string const& name) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for(unsigned char c: name) hash = (hash ^ c) * 0x100000001b3ULL;
+    return hash;
+}
+
+// uXXXX或uXXXX-...形式的名称的码位，否则返回0x110000
+unsigned long RenderCodepoint(std::string const& name) {
+    if(name.size() < 2 || name[0] != 'u') return 0x110000;
+    char*         end;
+    unsigned long code = std::strtoul(name.c_str() + 1, &end, 16);
+    if(end == name.c_str() + 1 || (*end != 0 && *end != '-') ||
+        code >= 0x110000)
+        return 0x110000;
+    return code;
+}
+
+std::vector<size_t> RenderPartition(std::vector<std::string> const& names,
+    std::string const& partition, size_t count, Kage::Kage& kage) {
+    std::vector<size_t> part(names.size());
+    if(partition == "hash") {
+        for(size_t i = 0; i < names.size(); i++)
+            part[i] = RenderNameHash(names[i]) % count;
+    } else if(partition == "range") {
+        std::vector<std::pair<unsigned long, size_t>> order;
+        for(size_t i = 0; i < names.size(); i++)
+            order.push_back({RenderCodepoint(names[i]), i});
+        std::sort(order.begin(), order.end());
+        for(size_t i = 0; i < order.size(); i++)
+            part[order[i].second] = i * count / order.size();
+    } else {
+        std::vector<double> costs(names.size());
+        for(size_t i = 0; i < names.size(); i++)
+            costs[i] = kage.EstimateCost(names[i]);
+        part = Kage::PartitionByCost(costs, count);
+    }
+    return part;
+}
+
+std::string RenderShardHeader(size_t total, size_t count, size_t index) {
+    std::stringstream ss;
+    ss << "KageShard " << RENDER_SHARD_VERSION << " " << total << " " << count
+       << " " << index << "\n";
+    return ss.str();
+}
+
+void RenderWriteShardEntry(std::ostream& out, RenderShardEntry const& entry) {
+    out << entry.index << " " << entry.name << " " << entry.data.size() << " "
+        << (entry.missing ? 1 : 0) << "\n"
+        << entry.data << "\n";
+}
+
+bool RenderShardReader::Fail(const char* reason) {
+    std::fprintf(stderr, "%s: %s\n", _path.c_str(), reason);
+    _failed = true;
+    return false;
+}
+
+bool RenderShardReader::Open(std::string path) {
+    _path = path;
+    _in.open(path, std::ios::binary);
+    if(!_in) return Fail("cannot open");
+    std::string line, magic;
+    int         version = 0;
+    std::getline(_in, line);
+    std::stringstream ss(line);
+    if(!(ss >> magic >> version >> total >> count >> index) ||
+        magic != "KageShard")
+        return Fail("not a shard file");
+    if(version != RENDER_SHARD_VERSION) return Fail("unsupported version");
+    if(count == 0 || index >= count) return Fail("invalid shard header");
+    return true;
+}
+
+bool RenderShardReader::Next(RenderShardEntry& entry) {
+    std::string line;
+    if(_failed || !std::getline(_in, line)) return false;
+    // 名称可能含空格，位置取第一个字段，字节数与是否缺字取最后两个
+    size_t first = line.find(' '), last = line.rfind(' ');
+    size_t middle = last == std::string::npos || last == 0
+        ? std::string::npos
+        : line.rfind(' ', last - 1);
+    if(first == std::string::npos || middle == std::string::npos ||
+        middle <= first)
+        return Fail("invalid entry");
+    char*  end;
+    size_t size;
+    entry.index = std::strtoull(line.c_str(), &end, 10);
+    if(end != line.c_str() + first) return Fail("invalid entry");
+    size = std::strtoull(line.c_str() + middle + 1, &end, 10);
+    if(end != line.c_str() + last || end == line.c_str() + middle + 1)
+        return Fail("invalid entry");
+    std::string missing = line.substr(last + 1);
+    if(missing != "0" && missing != "1") return Fail("invalid entry");
+    entry.name    = line.substr(first + 1, middle - first - 1);
+    entry.missing = missing == "1";
+    entry.data.resize(size);
+    if(size > 0) _in.read(&entry.data[0], size);
+    if(!_in || _in.get() != '\n') return Fail("truncated entry");
+    return true;
+}
+
+bool RenderShardReader::Failed() {
+    return _failed;
+}
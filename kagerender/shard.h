@@ -0,0 +1,51 @@
+#ifndef _SHARD_H
+#define _SHARD_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "kage.h"
+
+// 多进程分片生成：各进程以--shard i/K生成一部分字形并写出分片文件，
+// 再以--merge按输入顺序合并；合并的结果与分片数无关
+// 分片文件："KageShard 版本 字形总数 分片数 分片编号"一行，之后每个字形为
+// "输入中的位置 名称 字节数 是否缺字"一行，紧接步长为0（不量化）的二进制
+// 轮廓与一个换行；字形按位置从小到大排列
+const int RENDER_SHARD_VERSION = 1;
+
+typedef struct {
+    size_t      index;
+    std::string name;
+    bool        missing;
+    std::string data;
+} RenderShardEntry;
+
+bool RenderParseShard(std::string text, size_t& index, size_t& count); // i/K
+bool RenderValidPartition(std::string const& partition);
+
+// 返回每个字形所在的分片，只由名称（cost时还有部件数据）决定
+// hash：名称的FNV-1a哈希；range：按码位排序后分为字形数相同的连续区间，
+// 不是uXXXX形式的名称排在最后；cost：按EstimateCost使各分片的开销接近
+std::vector<size_t> RenderPartition(std::vector<std::string> const& names,
+    std::string const& partition, size_t count, Kage::Kage& kage);
+
+std::string RenderShardHeader(size_t total, size_t count, size_t index);
+void RenderWriteShardEntry(std::ostream& out, RenderShardEntry const& entry);
+
+class RenderShardReader {
+    std::ifstream _in;
+    std::string   _path;
+    bool          _failed = false;
+
+    bool Fail(const char* reason);
+
+public:
+    size_t total, count, index;
+
+    bool Open(std::string path); // 读入文件头，失败时报告到标准错误
+    bool Next(RenderShardEntry& entry); // 文件结束或出错时返回false
+    bool Failed();
+};
+
+#endif
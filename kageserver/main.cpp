@@ -0,0 +1,437 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "kage.h"
+#include "options.h"
+#include "stats.h"
+
+// 常驻的字形生成服务，部件数据只在启动时读入一次
+// 用法：kage-server --socket path --dump file [--dump file ...]
+//       [--font mincho|gothic] [--weight name|number] [--threads N]
+//       [--batch N] [--queue N] [--deadline ms]
+// 协议：每行一个请求，同一连接上的应答按请求的顺序返回
+//   RENDER 名称 [格式] [期限毫秒]  ->  OK 名称 字节数\n数据\n
+//                                      或 ERR 名称 原因\n
+//   STATS                          ->  OK stats 字节数\n统计\n
+//   PING                           ->  OK pong 0\n\n
+// 原因为missing（找不到）、busy（队列已满）、timeout（超过期限）或
+// bad-request；期限为0时使用--deadline，两者均为0时不限
+// 每个连接上未应答的请求至多--queue个，达到上限时暂停读取该连接
+
+const size_t SERVER_MAX_LINE = 4096; // 超过此长度仍无换行时断开连接
+
+typedef std::chrono::steady_clock ServerClock;
+
+typedef struct ServerRequest {
+    std::string             name, format;
+    ServerClock::time_point deadline;
+    std::mutex              mutex;
+    std::condition_variable finished;
+    bool                    done = false, cancelled = false;
+    std::string             result, error;
+} ServerRequest;
+
+typedef std::shared_ptr<ServerRequest> ServerRequestPtr;
+
+typedef struct {
+    std::atomic<uint64_t> requests, rendered, batches, coalesced, busy,
+        timeouts, missing;
+} ServerCounters;
+
+void ServerFinish(ServerRequestPtr const& request, std::string result,
+    std::string error) {
+    std::lock_guard<std::mutex> lock(request->mutex);
+    request->result = std::move(result), request->error = std::move(error);
+    request->done   = true;
+    request->finished.notify_all();
+}
+
+// 有界的请求队列，满时直接拒绝而不阻塞读取请求的线程
+class ServerQueue {
+    std::mutex                   _mutex;
+    std::condition_variable      _available;
+    std::deque<ServerRequestPtr> _items;
+    size_t                       _limit;
+    bool                         _closed = false;
+
+public:
+    ServerQueue(size_t limit) {
+        _limit = limit;
+    }
+
+    bool Push(ServerRequestPtr request) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(_closed || _items.size() >= _limit) return false;
+        _items.push_back(request);
+        _available.notify_one();
+        return true;
+    }
+
+    // 取出至多max个请求，队列关闭且为空时返回false
+    bool PopBatch(std::vector<ServerRequestPtr>& batch, size_t max) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _available.wait(lock, [&] { return _closed || !_items.empty(); });
+        if(_items.empty()) return false;
+        batch.clear();
+        while(!_items.empty() && batch.size() < max) {
+            batch.push_back(_items.front());
+            _items.pop_front();
+        }
+        if(!_items.empty()) _available.notify_one();
+        return true;
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closed = true;
+        _available.notify_all();
+    }
+
+    size_t Size() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _items.size();
+    }
+};
+
+// 同一批中相同的字形与格式只生成一次，过期或已放弃的请求不再生成
+void ServerWorker(Kage::Kage& kage, ServerQueue& queue, size_t batchSize,
+    ServerCounters& counters) {
+    std::vector<ServerRequestPtr> batch;
+    while(queue.PopBatch(batch, batchSize)) {
+        counters.batches++;
+        auto now = ServerClock::now();
+        std::map<std::pair<std::string, std::string>,
+            std::vector<ServerRequestPtr>>
+            groups;
+        for(auto& i: batch) {
+            bool cancelled;
+            {
+                std::lock_guard<std::mutex> lock(i->mutex);
+                cancelled = i->cancelled;
+            }
+            if(cancelled || i->deadline <= now) {
+                if(!cancelled) counters.timeouts++; // 已放弃的已由写回线程计数
+                ServerFinish(i, "", "timeout");
+            } else
+                groups[{i->name, i->format}].push_back(i);
+        }
+        for(auto& i: groups) {
+            auto data = kage.SearchBuhin(i.first.first);
+            std::string result, error;
+            if(data.empty()) {
+                counters.missing += i.second.size();
+                error = "missing";
+            } else {
+                Kage::Canva canva;
+                kage.MakeGlyph2(canva, data);
+                result = RenderExport(canva, i.first.second);
+                counters.rendered++;
+                counters.coalesced += i.second.size() - 1;
+            }
+            for(auto& j: i.second) ServerFinish(j, result, error);
+        }
+    }
+}
+
+bool ServerSend(int fd, std::string const& data) {
+    size_t sent = 0;
+    while(sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent,
+#ifdef MSG_NOSIGNAL
+            MSG_NOSIGNAL
+#else
+            0
+#endif
+        );
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+// 每个连接由两个线程处理：一个读取并排队请求，一个按顺序等待并写回应答
+class ServerConnection {
+    int                          _fd;
+    std::mutex                   _mutex;
+    std::condition_variable      _changed, _space;
+    std::deque<ServerRequestPtr> _pending; // 至多_limit个
+    size_t                       _limit;
+    bool                         _eof = false;
+    std::thread                  _reader, _writer;
+    std::atomic<bool>            _finished;
+
+    void Read(ServerQueue& queue, ServerCounters& counters,
+        std::chrono::milliseconds defaultDeadline) {
+        std::string buffer;
+        char        chunk[4096];
+        while(true) {
+            ssize_t n = recv(_fd, chunk, sizeof(chunk), 0);
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) break;
+            buffer.append(chunk, n);
+            size_t begin = 0, end;
+            while((end = buffer.find('\n', begin)) != std::string::npos) {
+                // 客户端不读取应答时在此等待，不再接收新的请求
+                std::unique_lock<std::mutex> lock(_mutex);
+                _space.wait(lock, [&] { return _pending.size() < _limit; });
+                lock.unlock();
+                auto request = Parse(buffer.substr(begin, end - begin), queue,
+                    counters, defaultDeadline);
+                begin = end + 1;
+                lock.lock();
+                _pending.push_back(request);
+                _changed.notify_one();
+            }
+            buffer.erase(0, begin);
+            if(buffer.size() > SERVER_MAX_LINE) break;
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        _eof = true;
+        _changed.notify_one();
+    }
+
+    ServerRequestPtr Parse(std::string line, ServerQueue& queue,
+        ServerCounters& counters, std::chrono::milliseconds defaultDeadline) {
+        if(!line.empty() && line.back() == '\r') line.pop_back();
+        std::stringstream ss(line);
+        std::string       command, format = "svg";
+        long              deadline = 0;
+        auto              request  = std::make_shared<ServerRequest>();
+        ss >> command;
+        if(command == "PING") {
+            request->name = "pong", request->done = true;
+        } else if(command == "STATS") {
+            request->name = "stats", request->done = true;
+            request->result = FormatCounters(queue, counters);
+        } else if(command == "RENDER" && ss >> request->name) {
+            counters.requests++;
+            if(!(ss >> format)) format = "svg";
+            if(!(ss >> deadline)) deadline = 0;
+            request->format = format;
+            auto timeout    = deadline > 0
+                   ? std::chrono::milliseconds(deadline)
+                   : defaultDeadline;
+            request->deadline = timeout.count() > 0
+                ? ServerClock::now() + timeout
+                : ServerClock::time_point::max();
+            if(!RenderValidFormat(format) || deadline < 0)
+                request->done = true, request->error = "bad-request";
+            else if(!queue.Push(request)) {
+                counters.busy++;
+                request->done = true, request->error = "busy";
+            }
+        } else {
+            request->name = "-", request->done = true;
+            request->error = "bad-request";
+        }
+        return request;
+    }
+
+    void Write(ServerCounters& counters) {
+        bool broken = false;
+        while(true) {
+            ServerRequestPtr request;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _changed.wait(lock, [&] { return _eof || !_pending.empty(); });
+                if(_pending.empty()) break;
+                request = _pending.front();
+                _pending.pop_front();
+                _space.notify_one();
+            }
+            std::string response;
+            {
+                std::unique_lock<std::mutex> lock(request->mutex);
+                if(request->deadline == ServerClock::time_point::max())
+                    request->finished.wait(lock, [&] { return request->done; });
+                else if(!request->finished.wait_until(lock, request->deadline,
+                            [&] { return request->done; })) {
+                    request->cancelled = true; // 仍在队列中时不再生成
+                    counters.timeouts++;
+                    request->error = "timeout";
+                }
+                if(!request->error.empty())
+                    response = "ERR " + request->name + " " + request->error +
+                        "\n";
+                else
+                    response = "OK " + request->name + " " +
+                        std::to_string(request->result.size()) + "\n" +
+                        request->result + "\n";
+            }
+            if(!broken && !ServerSend(_fd, response)) {
+                broken = true; // 继续取出剩余的请求，直到读取线程结束
+                shutdown(_fd, SHUT_RDWR);
+            }
+        }
+        _finished = true;
+    }
+
+public:
+    ServerConnection(int fd, ServerQueue& queue, ServerCounters& counters,
+        std::chrono::milliseconds defaultDeadline, size_t limit) {
+        _fd = fd, _limit = limit, _finished = false;
+        _reader = std::thread([this, &queue, &counters, defaultDeadline] {
+            Read(queue, counters, defaultDeadline);
+        });
+        _writer = std::thread([this, &counters] { Write(counters); });
+    }
+
+    ~ServerConnection() {
+        Shutdown();
+        _reader.join(), _writer.join();
+        close(_fd);
+    }
+
+    void Shutdown() {
+        shutdown(_fd, SHUT_RDWR);
+    }
+
+    bool Finished() {
+        return _finished;
+    }
+
+    static std::string FormatCounters(
+        ServerQueue& queue, ServerCounters& counters) {
+        char line[256];
+        std::snprintf(line, sizeof(line),
+            "requests %llu rendered %llu batches %llu coalesced %llu busy "
+            "%llu timeouts %llu missing %llu queued %zu\n",
+            (unsigned long long)counters.requests,
+            (unsigned long long)counters.rendered,
+            (unsigned long long)counters.batches,
+            (unsigned long long)counters.coalesced,
+            (unsigned long long)counters.busy,
+            (unsigned long long)counters.timeouts,
+            (unsigned long long)counters.missing, queue.Size());
+        return line + Kage::FormatStats(Kage::GetStats());
+    }
+};
+
+volatile std::sig_atomic_t serverStop = 0;
+
+void ServerSignal(int) {
+    serverStop = 1;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> dumps;
+    std::string              socketPath;
+    Kage::KageFontType       font   = Kage::KAGEFONT_MINCHO;
+    double                   weight = 0;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t batch = 32, queueLimit = 4096;
+    long   deadline = 0;
+    bool   usage    = false;
+    for(int i = 1; i < argc; i++) {
+        std::string arg   = argv[i];
+        bool        value = i + 1 < argc;
+        if(arg == "--socket" && value)
+            socketPath = argv[++i];
+        else if(arg == "--dump" && value)
+            dumps.push_back(argv[++i]);
+        else if(arg == "--font" && value)
+            usage |= !RenderParseFont(argv[++i], font);
+        else if(arg == "--weight" && value)
+            usage |= !RenderParseWeight(argv[++i], weight);
+        else if(arg == "--threads" && value)
+            threads = std::max((size_t)1,
+                (size_t)std::strtoul(argv[++i], nullptr, 10));
+        else if(arg == "--batch" && value)
+            batch = std::max((size_t)1,
+                (size_t)std::strtoul(argv[++i], nullptr, 10));
+        else if(arg == "--queue" && value)
+            queueLimit = std::max((size_t)1,
+                (size_t)std::strtoul(argv[++i], nullptr, 10));
+        else if(arg == "--deadline" && value)
+            deadline = std::max(0l, std::strtol(argv[++i], nullptr, 10));
+        else
+            usage = true;
+    }
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(usage || dumps.empty() || socketPath.empty() ||
+        socketPath.size() >= sizeof(address.sun_path)) {
+        std::fprintf(stderr,
+            "usage: %s --socket path --dump file [--dump file ...]\n"
+            "       [--font mincho|gothic] [--weight name|number] "
+            "[--threads N]\n"
+            "       [--batch N] [--queue N] [--deadline ms]\n",
+            argv[0]);
+        return 1;
+    }
+    std::strcpy(address.sun_path, socketPath.c_str());
+
+    Kage::Kage kage(font, weight);
+    if(!RenderLoadDumps(kage, dumps)) return 1;
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath.c_str());
+    if(listener < 0 ||
+        bind(listener, (sockaddr*)&address, sizeof(address)) < 0 ||
+        listen(listener, SOMAXCONN) < 0) {
+        std::fprintf(stderr, "cannot listen on %s: %s\n", socketPath.c_str(),
+            std::strerror(errno));
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, ServerSignal);
+    std::signal(SIGTERM, ServerSignal);
+
+    ServerQueue    queue(queueLimit);
+    ServerCounters counters;
+    for(auto i: {&counters.requests, &counters.rendered, &counters.batches,
+            &counters.coalesced, &counters.busy, &counters.timeouts,
+            &counters.missing})
+        i->store(0);
+    std::vector<std::thread> workers;
+    for(size_t i = 0; i < threads; i++)
+        workers.emplace_back(ServerWorker, std::ref(kage), std::ref(queue),
+            batch, std::ref(counters));
+    std::fprintf(stderr, "listening on %s with %zu threads\n",
+        socketPath.c_str(), threads);
+
+    std::list<std::unique_ptr<ServerConnection>> connections;
+    while(!serverStop) {
+        pollfd p = {listener, POLLIN, 0};
+        if(poll(&p, 1, 200) > 0 && (p.revents & POLLIN)) {
+            int fd = accept(listener, nullptr, nullptr);
+            if(fd >= 0)
+                connections.emplace_back(new ServerConnection(fd, queue,
+                    counters, std::chrono::milliseconds(deadline), queueLimit));
+        }
+        connections.remove_if(
+            [](std::unique_ptr<ServerConnection> const& i) {
+                return i->Finished();
+            });
+    }
+
+    close(listener);
+    unlink(socketPath.c_str());
+    connections.clear(); // 断开所有连接并等待已排队的请求完成
+    queue.Close();
+    for(auto& i: workers) i.join();
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include <algorithm>
 
 #include "bezier.h"
+#include "stats.h"
 
 namespace Kage {
 
@@ -13,13 +14,16 @@ namespace Kage {
         std::function<double(double)> const&                width_func_d,
         std::vector<CubicSpline>& bez1, std::vector<CubicSpline>& bez2) {
         std::vector<Point> a1(BEZIER_STEPS + 1), a2(BEZIER_STEPS + 1);
-        for(auto tt = 0; tt <= BEZIER_STEPS; tt++) {
-            double t  = (double)tt / BEZIER_STEPS;
-            Point  xy = Point(x_fun(t), y_fun(t)),
-                  iab = Point(dx_fun(t), dy_fun(t)).UnitNormalVector() *
-                width_func(t);
-            a1[tt]                = xy - iab;
-            a2[BEZIER_STEPS - tt] = xy + iab; // reverse
+        {
+            KAGE_STATS_SCOPE(STATS_CURVE_SAMPLE);
+            for(auto tt = 0; tt <= BEZIER_STEPS; tt++) {
+                double t  = (double)tt / BEZIER_STEPS;
+                Point  xy = Point(x_fun(t), y_fun(t)),
+                      iab = Point(dx_fun(t), dy_fun(t)).UnitNormalVector() *
+                    width_func(t);
+                a1[tt]                = xy - iab;
+                a2[BEZIER_STEPS - tt] = xy + iab; // reverse
+            }
         }
         // bez1 = FitCurve(a1, 0.03), bez2 = FitCurve(a2, 0.03);
         bez1 = FitCurve(a1, 0.1), bez2 = FitCurve(a2, 0.1); // Modified(2025/8/28)
@@ -35,12 +39,15 @@ namespace Kage {
         std::function<Point(double)> const&                  dir_func,
         std::vector<CubicSpline>& bez1, std::vector<CubicSpline>& bez2) {
         std::vector<Point> a1(BEZIER_STEPS + 1), a2(BEZIER_STEPS + 1);
-        for(auto tt = 0; tt <= BEZIER_STEPS; tt++) {
-            double t              = (double)tt / BEZIER_STEPS;
-            Point  xy             = Point(x_fun(t), y_fun(t)),
-                  iab             = dir_func(t) * width_func(t);
-            a1[tt]                = xy - iab;
-            a2[BEZIER_STEPS - tt] = xy + iab; // reverse
+        {
+            KAGE_STATS_SCOPE(STATS_CURVE_SAMPLE);
+            for(auto tt = 0; tt <= BEZIER_STEPS; tt++) {
+                double t              = (double)tt / BEZIER_STEPS;
+                Point  xy             = Point(x_fun(t), y_fun(t)),
+                      iab             = dir_func(t) * width_func(t);
+                a1[tt]                = xy - iab;
+                a2[BEZIER_STEPS - tt] = xy + iab; // reverse
+            }
         }
         // bez1 = FitCurve(a1, 0.03), bez2 = FitCurve(a2, 0.03);
         bez1 = FitCurve(a1, 0.1), bez2 = FitCurve(a2, 0.1); // Modified(2025/8/28)
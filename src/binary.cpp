@@ -0,0 +1,206 @@
+#include <cmath>
+#include <cstring>
+
+#include "binary.h"
+#include "stats.h"
+
+namespace Kage {
+
+    const char    BINARY_MAGIC[3]      = {'K', 'G', 'O'};
+    const uint8_t BINARY_VERSION       = 1;
+    const uint8_t BINARY_VERSION_HOLES = 2;  // 轮廓开头含有洞的标记
+    const size_t  BINARY_HEADER        = 12; // 不含轮廓数
+
+    void BinaryWriteVarint(std::string& buffer, uint64_t v) {
+        while(v >= 0x80) {
+            buffer += (char)((v & 0x7f) | 0x80);
+            v     >>= 7;
+        }
+        buffer += (char)v;
+    }
+
+    uint64_t BinaryZigzag(int64_t v) {
+        return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+    }
+
+    int64_t BinaryUnzigzag(uint64_t v) {
+        return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+    }
+
+    // 按补码回绕相加，损坏的数据不会造成有符号整数溢出
+    int64_t BinaryAddDelta(int64_t v, uint64_t zigzag) {
+        return (int64_t)((uint64_t)v + (uint64_t)BinaryUnzigzag(zigzag));
+    }
+
+    void BinaryWriteDouble(std::string& buffer, double v) {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        for(int i = 0; i < 8; i++)
+            buffer += (char)(bits >> (8 * i) & 0xff);
+    }
+
+    double BinaryReadDouble(const uint8_t* p) {
+        uint64_t bits = 0;
+        double   v;
+        for(int i = 0; i < 8; i++)
+            bits |= (uint64_t)p[i] << (8 * i);
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+
+    std::string Canva2Binary(Canva canva, double step) {
+        KAGE_STATS_SCOPE(STATS_EXPORT);
+        if(!(step >= 0) || !std::isfinite(step)) return "";
+        std::string buffer(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+        auto        contours = canva.Contours();
+        bool        holes = false;
+        for(auto& c: contours)
+            if(c.isHole()) holes = true;
+        buffer += (char)(holes ? BINARY_VERSION_HOLES : BINARY_VERSION);
+        BinaryWriteDouble(buffer, step);
+        BinaryWriteVarint(buffer, contours.size());
+        int64_t x = 0, y = 0;
+        for(auto& c: contours) {
+            auto&  pts   = c.Points();
+            auto&  types = c.PointTypes();
+            size_t n     = pts.size();
+            if(holes)
+                BinaryWriteVarint(buffer,
+                    (uint64_t)n << 2 | c.isHole() << 1 | c.isClosed());
+            else
+                BinaryWriteVarint(buffer, (uint64_t)n << 1 | c.isClosed());
+            // 点类型，每字节4个
+            for(size_t i = 0; i < n; i += 4) {
+                uint8_t tags = 0;
+                for(size_t j = i; j < n && j < i + 4; j++)
+                    tags |= (types[j] & 3) << (2 * (j - i));
+                buffer += (char)tags;
+            }
+            for(auto& p: pts) {
+                if(step == 0) {
+                    BinaryWriteDouble(buffer, p.x);
+                    BinaryWriteDouble(buffer, p.y);
+                    continue;
+                }
+                double qx = std::round(p.x / step), qy = std::round(p.y / step);
+                if(!std::isfinite(qx) || !std::isfinite(qy) ||
+                    std::fabs(qx) > 4e18 || std::fabs(qy) > 4e18)
+                    return "";
+                BinaryWriteVarint(buffer, BinaryZigzag((int64_t)qx - x));
+                BinaryWriteVarint(buffer, BinaryZigzag((int64_t)qy - y));
+                x = (int64_t)qx, y = (int64_t)qy;
+            }
+        }
+        return buffer;
+    }
+
+    CanvaView::CanvaView(const void* data, size_t size) {
+        _begin = (const uint8_t*)data, _end = _begin + size;
+        _vaild = size >= BINARY_HEADER &&
+            std::memcmp(_begin, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0 &&
+            (_begin[3] == BINARY_VERSION || _begin[3] == BINARY_VERSION_HOLES);
+        _holes = _vaild && _begin[3] == BINARY_VERSION_HOLES;
+        _step = 0, _size = 0, _body = _end;
+        if(_vaild) {
+            uint64_t count = 0;
+            _step  = BinaryReadDouble(_begin + 4);
+            _pos   = _begin + BINARY_HEADER;
+            _vaild = _step >= 0 && std::isfinite(_step) && ReadVarint(count);
+            if(_vaild) _size = count, _body = _pos;
+        }
+        Rewind();
+    }
+
+    CanvaView::CanvaView(const std::string& data):
+        CanvaView(data.data(), data.size()) {}
+
+    bool CanvaView::ReadVarint(uint64_t& v) {
+        v = 0;
+        for(int shift = 0; shift < 64; shift += 7) {
+            if(_pos >= _end) return false;
+            uint8_t byte = *_pos++;
+            v |= (uint64_t)(byte & 0x7f) << shift;
+            if(!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool CanvaView::isVaild() {
+        return _vaild;
+    }
+
+    double CanvaView::Step() {
+        return _step;
+    }
+
+    size_t CanvaView::Size() {
+        return _size;
+    }
+
+    void CanvaView::Rewind() {
+        _pos = _body, _tags = _body, _contour = 0, _remaining = 0,
+        _tagIndex = 0, _x = 0, _y = 0, _hole = false;
+    }
+
+    // 移动到下一个轮廓，当前轮廓中未读的点会被跳过
+    bool CanvaView::NextContour(size_t& points, bool& closed) {
+        Point  p;
+        ptType type;
+        while(_remaining > 0)
+            if(!NextPoint(p, type)) return false;
+        if(!_vaild || _contour >= _size) return false;
+        uint64_t header;
+        if(!ReadVarint(header)) return _vaild = false;
+        _hole = _holes && (header & 2);
+        if(_holes) header = header >> 2 << 1 | (header & 1);
+        if((header >> 1) > (uint64_t)(_end - _pos) * 4) // 点类型所需的字节
+            return _vaild = false;
+        points = _remaining = header >> 1, closed = header & 1;
+        _tags = _pos, _tagIndex = 0, _pos += (points + 3) / 4;
+        _contour++;
+        return true;
+    }
+
+    bool CanvaView::isHole() {
+        return _hole;
+    }
+
+    bool CanvaView::NextPoint(Point& p, ptType& type) {
+        if(!_vaild || _remaining == 0) return false;
+        type = _tags[_tagIndex / 4] >> (2 * (_tagIndex % 4)) & 3;
+        if(_step == 0) {
+            if(_end - _pos < 16) return _vaild = false;
+            p = Point(BinaryReadDouble(_pos), BinaryReadDouble(_pos + 8));
+            _pos += 16;
+        } else {
+            uint64_t dx, dy;
+            if(!ReadVarint(dx) || !ReadVarint(dy)) return _vaild = false;
+            _x = BinaryAddDelta(_x, dx), _y = BinaryAddDelta(_y, dy);
+            p   = Point(_x * _step, _y * _step);
+        }
+        _tagIndex++, _remaining--;
+        return true;
+    }
+
+    bool CanvaView::ToCanva(Canva& canva) {
+        Rewind();
+        std::vector<Contour> contours;
+        size_t               points;
+        bool                 closed;
+        while(NextContour(points, closed)) {
+            Contour contour;
+            Point   p;
+            ptType  type;
+            while(NextPoint(p, type))
+                contour.Push(p, type);
+            if(contour.Size() != points) return false;
+            contour.SetClosed(closed);
+            contour.SetHole(isHole());
+            contours.push_back(contour);
+        }
+        if(!_vaild || contours.size() != _size) return false;
+        canva._contours.swap(contours);
+        return true;
+    }
+
+} // namespace Kage
@@ -0,0 +1,149 @@
+#include "buhindb.h"
+
+namespace Kage {
+
+    const uint32_t BUHIN_DB_MASK = (1u << BUHIN_DB_BITS) - 1;
+
+    // 编号超出depth层树的范围
+    bool BuhinOutOfRange(uint32_t id, unsigned depth) {
+        return ((uint64_t)id >> (BUHIN_DB_BITS * (depth + 1))) != 0;
+    }
+
+    void BuhinCollectIds(std::shared_ptr<const BuhinNode> const& node,
+        unsigned level, uint32_t prefix, std::vector<uint32_t>& ids) {
+        if(!node) return;
+        for(uint32_t i = 0; i < node->children.size(); i++)
+            BuhinCollectIds(node->children[i], level - 1,
+                prefix | i << (BUHIN_DB_BITS * level), ids);
+        for(uint32_t i = 0; i < node->data.size(); i++)
+            if(node->data[i]) ids.push_back(prefix | i);
+    }
+
+    // 复制路径上的节点，返回新的子树
+    std::shared_ptr<const BuhinNode> BuhinNodeSet(
+        std::shared_ptr<const BuhinNode> const& node, unsigned level,
+        uint32_t id, BuhinData data, bool& added) {
+        auto copy = node ? std::make_shared<BuhinNode>(*node)
+                         : std::make_shared<BuhinNode>();
+        auto i    = id >> (BUHIN_DB_BITS * level) & BUHIN_DB_MASK;
+        if(level == 0) {
+            if(copy->data.empty()) copy->data.resize(BUHIN_DB_MASK + 1);
+            added         = !copy->data[i];
+            copy->data[i] = data;
+        } else {
+            if(copy->children.empty())
+                copy->children.resize(BUHIN_DB_MASK + 1);
+            copy->children[i] =
+                BuhinNodeSet(copy->children[i], level - 1, id, data, added);
+        }
+        return copy;
+    }
+
+    // 在叶子中追加部件名，复制路径上的节点，返回新的子树
+    std::shared_ptr<const BuhinNameNode> BuhinNameSet(
+        std::shared_ptr<const BuhinNameNode> const& node, unsigned level,
+        size_t hash, std::string const& name, uint32_t id) {
+        auto copy = node ? std::make_shared<BuhinNameNode>(*node)
+                         : std::make_shared<BuhinNameNode>();
+        if(level == 0)
+            copy->entries.push_back({name, id});
+        else {
+            auto i = hash >> (BUHIN_DB_BITS * (level - 1)) & BUHIN_DB_MASK;
+            if(copy->children.empty())
+                copy->children.resize(BUHIN_DB_MASK + 1);
+            copy->children[i] =
+                BuhinNameSet(copy->children[i], level - 1, hash, name, id);
+        }
+        return copy;
+    }
+
+    BuhinSnapshot::BuhinSnapshot(std::shared_ptr<const BuhinVersion> version) {
+        _version = version;
+    }
+
+    BuhinData BuhinSnapshot::Find(uint32_t id) const {
+        if(BuhinOutOfRange(id, _version->depth)) return nullptr;
+        auto node = _version->root.get();
+        for(auto level = _version->depth; level > 0; level--) {
+            if(!node) return nullptr;
+            node = node->children[id >> (BUHIN_DB_BITS * level) & BUHIN_DB_MASK]
+                       .get();
+        }
+        if(!node) return nullptr;
+        return node->data[id & BUHIN_DB_MASK];
+    }
+
+    BuhinData BuhinSnapshot::Find(std::string const& name) const {
+        auto hash = std::hash<std::string>()(name);
+        auto node = _version->names.get();
+        for(auto level = BUHIN_NAME_LEVELS; node && level > 0; level--)
+            node = node->children[hash >> (BUHIN_DB_BITS * (level - 1)) &
+                                  BUHIN_DB_MASK]
+                       .get();
+        if(!node) return nullptr;
+        for(auto& i: node->entries)
+            if(i.first == name) return Find(i.second);
+        return nullptr;
+    }
+
+    size_t BuhinSnapshot::Size() const {
+        return _version->size;
+    }
+
+    std::vector<uint32_t> BuhinSnapshot::Ids() const {
+        std::vector<uint32_t> ids;
+        ids.reserve(_version->size);
+        BuhinCollectIds(_version->root, _version->depth, 0, ids);
+        return ids;
+    }
+
+    BuhinDB::BuhinDB() {
+        auto version   = std::make_shared<BuhinVersion>();
+        version->root  = nullptr;
+        version->depth = 0, version->size = 0;
+        version->names = nullptr;
+        _current       = version;
+    }
+
+    BuhinSnapshot BuhinDB::Snapshot() const {
+        return BuhinSnapshot(std::atomic_load(&_current));
+    }
+
+    void BuhinDB::Publish(
+        uint32_t id, std::string const& name, BuhinData data) {
+        auto version = std::make_shared<BuhinVersion>(*_current);
+        // 编号超出范围时在上方增加一层
+        while(BuhinOutOfRange(id, version->depth)) {
+            auto root = std::make_shared<BuhinNode>();
+            root->children.resize(BUHIN_DB_MASK + 1);
+            root->children[0] = version->root;
+            version->root     = root;
+            version->depth++;
+        }
+        bool added    = false;
+        version->root =
+            BuhinNodeSet(version->root, version->depth, id, data, added);
+        if(added) {
+            version->size++;
+            version->names = BuhinNameSet(version->names, BUHIN_NAME_LEVELS,
+                std::hash<std::string>()(name), name, id);
+        }
+        std::atomic_store(
+            &_current, std::shared_ptr<const BuhinVersion>(version));
+    }
+
+    void BuhinDB::Set(
+        uint32_t id, std::string const& name, std::vector<Stroke> data) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Publish(id, name, std::make_shared<const std::vector<Stroke>>(data));
+    }
+
+    bool BuhinDB::Insert(
+        uint32_t id, std::string const& name, std::vector<Stroke> data) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(Snapshot().Find(id)) return false;
+        Publish(id, name, std::make_shared<const std::vector<Stroke>>(data));
+        return true;
+    }
+
+} // namespace Kage
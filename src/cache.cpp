@@ -0,0 +1,150 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "bezier.h"
+#include "binary.h"
+#include "cache.h"
+
+namespace Kage {
+
+    const uint64_t CACHE_FNV_OFFSET = 0xcbf29ce484222325ULL;
+    const uint64_t CACHE_FNV_PRIME  = 0x100000001b3ULL;
+
+    // 按小端字节顺序计入哈希
+    void CacheHashInt(uint64_t& hash, uint64_t v, int bytes = 4) {
+        for(int i = 0; i < bytes; i++)
+            hash = (hash ^ (v >> (8 * i) & 0xff)) * CACHE_FNV_PRIME;
+    }
+
+    // -0与0、不同的NaN视为相同
+    void CacheHashDouble(uint64_t& hash, double v) {
+        uint64_t bits = 0x7ff8000000000000ULL;
+        if(v == 0) v = 0;
+        if(!std::isnan(v)) std::memcpy(&bits, &v, sizeof(bits));
+        CacheHashInt(hash, bits, 8);
+    }
+
+    void CacheHashPoint(uint64_t& hash, Point p) {
+        CacheHashDouble(hash, p.x), CacheHashDouble(hash, p.y);
+    }
+
+    // 只计入各类笔画实际使用的字段，未初始化的字段不影响结果
+    uint64_t GlyphHash(std::vector<Stroke> strokes, KageFontType type,
+        double size, SymbolTable& symbols) {
+        uint64_t hash = CACHE_FNV_OFFSET;
+        CacheHashInt(hash, RENDER_CACHE_VERSION);
+        CacheHashInt(hash, type), CacheHashDouble(hash, size);
+        CacheHashInt(hash, BEZIER_STEPS);
+        CacheHashInt(hash, strokes.size(), 8);
+        for(auto& s: strokes) {
+            CacheHashInt(hash, s.type);
+            if(s.type == STROKE_SPECIAL) {
+                CacheHashInt(hash, s.spe1), CacheHashInt(hash, s.spe2);
+                if(s.spe1 > 0)
+                    CacheHashPoint(hash, s.p1), CacheHashPoint(hash, s.p2);
+            } else if(s.type == STROKE_REFERENCE) {
+                auto name = symbols.Name(s.buhin);
+                CacheHashInt(hash, name.size(), 8);
+                for(auto c: name)
+                    CacheHashInt(hash, (uint8_t)c, 1);
+                CacheHashPoint(hash, s.p1), CacheHashPoint(hash, s.p2);
+                CacheHashPoint(hash, s.s1), CacheHashPoint(hash, s.s2);
+            } else {
+                CacheHashInt(hash, s.typeOpt);
+                CacheHashInt(hash, s.start), CacheHashInt(hash, s.startOpt);
+                CacheHashInt(hash, s.end), CacheHashInt(hash, s.endOpt);
+                CacheHashPoint(hash, s.p1), CacheHashPoint(hash, s.p2);
+                CacheHashPoint(hash, s.p3), CacheHashPoint(hash, s.p4);
+            }
+        }
+        return hash;
+    }
+
+    std::string GlyphHashString(uint64_t hash) {
+        char buffer[17];
+        snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long)hash);
+        return std::string(buffer);
+    }
+
+    RenderCache::RenderCache(size_t capacity, std::string directory):
+        _memory(capacity) {
+        _directory = directory;
+        if(!_directory.empty() && _directory.back() != '/' &&
+            _directory.back() != '\\')
+            _directory += '/';
+    }
+
+    std::string RenderCache::DiskPath(uint64_t hash) {
+        return _directory + GlyphHashString(hash) + ".kgo";
+    }
+
+    // 内存未命中时读取磁盘，读到的结果存入内存
+    bool RenderCache::Get(uint64_t hash, Canva& canva) {
+        std::string data;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto                        p = _memory.Get(hash);
+            if(p) data = *p;
+        }
+        bool fromDisk = false;
+        if(data.empty() && !_directory.empty()) {
+            FILE* fp = fopen(DiskPath(hash).c_str(), "rb");
+            if(fp) {
+                char   buffer[4096];
+                size_t n;
+                while((n = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+                    data.append(buffer, n);
+                fclose(fp);
+                fromDisk = true;
+            }
+        }
+        CanvaView view(data);
+        bool      hit = !data.empty() && view.ToCanva(canva);
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(hit && fromDisk) _memory.Put(hash, data, data.size());
+        hit ? _hits++ : _misses++;
+        return hit;
+    }
+
+    // 先写入临时文件再改名，其他进程不会读到不完整的文件
+    void RenderCache::Put(uint64_t hash, Canva canva) {
+        auto data = Canva2Binary(canva, 0);
+        if(data.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _memory.Put(hash, data, data.size());
+        }
+        if(_directory.empty()) return;
+        auto  path = DiskPath(hash),
+             temp = path + "." + std::to_string(std::random_device()()) + ".tmp";
+        FILE* fp   = fopen(temp.c_str(), "wb");
+        if(!fp) return;
+        bool ok = fwrite(data.data(), 1, data.size(), fp) == data.size();
+        ok      = fclose(fp) == 0 && ok;
+        if(!ok || std::rename(temp.c_str(), path.c_str()) != 0)
+            std::remove(temp.c_str());
+    }
+
+    void RenderCache::Clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _memory.Clear();
+    }
+
+    size_t RenderCache::Bytes() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _memory.Cost();
+    }
+
+    size_t RenderCache::Hits() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _hits;
+    }
+
+    size_t RenderCache::Misses() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _misses;
+    }
+
+} // namespace Kage
@@ -1,9 +1,13 @@
 #include <cmath>
+#include <utility>
 #include <vector>
 
 #include "bezier.h"
 #include "canva.h"
+#include "overlap.h"
 #include "point.h"
+#include "simplify.h"
+#include "stats.h"
 
 namespace Kage {
 
@@ -12,6 +16,10 @@ namespace Kage {
         _contours.clear();
     }
 
+    Canva::Canva(PathSink& sink) {
+        _sink = &sink;
+    }
+
     std::vector<Contour> Canva::Contours() {
         return _contours;
     }
@@ -23,6 +31,7 @@ namespace Kage {
 
     // polygons.js/Polygons/push
     size_t Canva::Push(Contour contour) {
+        KAGE_STATS_SCOPE(STATS_CANVA);
         // only a simple check
         double minx = 200, maxx = 0, miny = 200, maxy = 0;
         size_t error = 0;
@@ -34,19 +43,23 @@ namespace Kage {
             if(!i.isVaild()) error++;
         }
         if(error == 0 && minx != maxx && miny != maxy && contour.Size() >= 1) {
-            Contour newArray;
-            newArray.Push(contour.Shift());
-            while(contour.Size() != 0)
-                newArray.Push(contour.Shift());
-            if(newArray.Size() >= 1) _contours.push_back(newArray);
+            // 与逐点复制到新轮廓相同：闭合，点的种类规范化
+            contour.SetClosed(true);
+            for(auto& i: contour.PointTypes())
+                if(i != PT_QUAD && i != PT_CUBIC) i = PT_POINT;
+            if(_sink)
+                Contour2Sink(contour, *_sink);
+            else
+                _contours.push_back(std::move(contour));
         }
         return _contours.size();
     }
 
     // polygons.js/Polygons/concat
     size_t Canva::Concat(Canva canva) {
-        for(auto i: canva._contours)
-            _contours.push_back(i);
+        _contours.reserve(_contours.size() + canva._contours.size());
+        for(auto& i: canva._contours)
+            _contours.push_back(std::move(i));
         return _contours.size();
     }
 
@@ -54,6 +67,12 @@ namespace Kage {
         return _contours.size();
     }
 
+    // 将所有轮廓依次输出到sink
+    void Canva::Replay(PathSink& sink) {
+        for(auto& i: _contours)
+            Contour2Sink(i, sink);
+    }
+
     // fontcanvas.js/FontCanvas/drawLine
     void Canva::DrawLine(Point p1, Point p2, double halfWidth) {
         Contour    contour;
@@ -109,6 +128,7 @@ namespace Kage {
 
     // fontcanvas.js/FontCanvas/flip_left_right
     void Canva::FlipLR(Point p1, Point p2) {
+        KAGE_STATS_SCOPE(STATS_CANVA);
         for(auto& i: _contours) {
             if(isInside(i, p1, p2)) {
                 for(auto& j: i.Points())
@@ -120,6 +140,7 @@ namespace Kage {
 
     // fontcanvas.js/FontCanvas/flip_up_down
     void Canva::FlipUD(Point p1, Point p2) {
+        KAGE_STATS_SCOPE(STATS_CANVA);
         for(auto& i: _contours) {
             if(isInside(i, p1, p2)) {
                 for(auto& j: i.Points())
@@ -131,6 +152,7 @@ namespace Kage {
 
     // fontcanvas.js/FontCanvas/rotate90
     void Canva::Rotate90(Point p1, Point p2) {
+        KAGE_STATS_SCOPE(STATS_CANVA);
         for(auto& i: _contours) {
             if(isInside(i, p1, p2)) {
                 for(auto& j: i.Points()) {
@@ -144,6 +166,7 @@ namespace Kage {
 
     // fontcanvas.js/FontCanvas/rotate180
     void Canva::Rotate180(Point p1, Point p2) {
+        KAGE_STATS_SCOPE(STATS_CANVA);
         for(auto& i: _contours) {
             if(isInside(i, p1, p2)) {
                 for(auto& j: i.Points()) {
@@ -157,6 +180,7 @@ namespace Kage {
 
     // fontcanvas.js/FontCanvas/rotate270
     void Canva::Rotate270(Point p1, Point p2) {
+        KAGE_STATS_SCOPE(STATS_CANVA);
         for(auto& i: _contours) {
             if(isInside(i, p1, p2)) {
                 for(auto& j: i.Points()) {
@@ -168,4 +192,21 @@ namespace Kage {
         }
     }
 
+    // 合并重叠的轮廓，返回合并后的轮廓数
+    size_t Canva::RemoveOverlap(double tolerance) {
+        _contours = ::Kage::RemoveOverlap(_contours, tolerance);
+        return _contours.size();
+    }
+
+    // 简化所有轮廓，返回减少的点数
+    size_t Canva::Simplify(double tolerance, double grid) {
+        size_t saved = 0;
+        for(auto& i: _contours) {
+            auto simplified = SimplifyContour(i, tolerance, grid);
+            saved          += i.Size() - simplified.Size();
+            i               = simplified;
+        }
+        return saved;
+    }
+
 } // namespace Kage
@@ -9,6 +9,7 @@ namespace Kage {
         ptTypes.clear();
         pts.clear();
         _isClosed = true;
+        _isHole   = false;
     }
 
     // polygon.js/Polygon/constructor
@@ -20,6 +21,7 @@ namespace Kage {
         for(size_t i = 0; i < num; i++)
             ptTypes.at(i) = PT_POINT, pts.at(i) = Point(0, 0);
         _isClosed = true;
+        _isHole   = false;
     }
 
     std::vector<ptType>& Contour::PointTypes() {
@@ -34,6 +36,10 @@ namespace Kage {
         return _isClosed;
     }
 
+    bool Contour::isHole() {
+        return _isHole;
+    }
+
     // polygon.js/Polygon/push
     size_t Contour::Push(Point p, ptType type) {
         ptTypes.push_back(
@@ -90,10 +96,29 @@ namespace Kage {
         _isClosed = closed;
     }
 
+    void Contour::SetHole(bool hole) {
+        _isHole = hole;
+    }
+
     size_t Contour::Size() {
         return pts.size();
     }
 
+    double Contour::SignedArea() {
+        double area = 0;
+        for(size_t i = 0; i < pts.size(); i++) {
+            auto& a = pts[i];
+            auto& b = pts[(i + 1) % pts.size()];
+            area += a.x * b.y - a.y * b.x;
+        }
+        return area / 2;
+    }
+
+    void Contour::NormalizeOrientation() {
+        double area = SignedArea();
+        if(_isHole ? area > 0 : area < 0) Reverse();
+    }
+
     void Contour::MoveTo(Point p) {
         ptTypes.clear(), pts.clear();
         this->Push(p, PT_POINT);
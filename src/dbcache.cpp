@@ -0,0 +1,104 @@
+#include "dbcache.h"
+
+namespace Kage {
+
+    DBsearchCache::DBsearchCache(size_t capacity,
+        std::chrono::milliseconds ttl, std::chrono::milliseconds negativeTtl):
+        _entries(capacity) {
+        _ttl = ttl, _negativeTtl = negativeTtl;
+    }
+
+    void DBsearchCache::Store(std::string name, std::vector<Stroke> strokes) {
+        auto ttl = strokes.empty() ? _negativeTtl : _ttl;
+        auto expires = ttl.count() == 0
+            ? std::chrono::steady_clock::time_point::max()
+            : std::chrono::steady_clock::now() + ttl;
+        _entries.Put(name, {strokes, expires}, 1);
+    }
+
+    std::vector<Stroke> DBsearchCache::Fetch(std::string name,
+        std::function<std::vector<Stroke>(std::string)> const& search) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        auto                         entry = _entries.Get(name);
+        if(entry) {
+            if(entry->expires > std::chrono::steady_clock::now()) {
+                _hits++;
+                return entry->strokes;
+            }
+            _entries.Erase(name);
+        }
+        // 已有相同的查询正在进行时等待其结果
+        auto it = _pending.find(name);
+        if(it != _pending.end()) {
+            auto future = it->second;
+            _hits++;
+            lock.unlock();
+            return future.get();
+        }
+        std::promise<std::vector<Stroke>> promise;
+        _pending[name] = promise.get_future().share();
+        size_t epoch   = _epoch;
+        _misses++;
+        lock.unlock();
+
+        std::vector<Stroke> strokes;
+        try {
+            strokes = search(name);
+        } catch(...) {
+            lock.lock();
+            _pending.erase(name);
+            lock.unlock();
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+        lock.lock();
+        if(epoch == _epoch) Store(name, strokes);
+        _pending.erase(name);
+        lock.unlock();
+        promise.set_value(strokes);
+        return strokes;
+    }
+
+    // 查看未过期的缓存，不计入命中次数
+    bool DBsearchCache::Peek(std::string name, std::vector<Stroke>& strokes) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto                        entry = _entries.Get(name);
+        if(!entry || entry->expires <= std::chrono::steady_clock::now())
+            return false;
+        strokes = entry->strokes;
+        return true;
+    }
+
+    void DBsearchCache::Put(std::string name, std::vector<Stroke> strokes) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Store(name, strokes);
+    }
+
+    void DBsearchCache::Invalidate(std::string name) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _entries.Erase(name);
+        _epoch++;
+    }
+
+    void DBsearchCache::Clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _entries.Clear();
+        _epoch++;
+    }
+
+    size_t DBsearchCache::Size() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _entries.Size();
+    }
+
+    size_t DBsearchCache::Hits() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _hits;
+    }
+
+    size_t DBsearchCache::Misses() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _misses;
+    }
+
+} // namespace Kage
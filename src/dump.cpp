@@ -0,0 +1,34 @@
+#include "dump.h"
+
+namespace Kage {
+
+    std::string DumpTrim(std::string const& str, size_t begin, size_t end) {
+        while(begin < end && (str[begin] == ' ' || str[begin] == '\t'))
+            begin++;
+        while(end > begin && (str[end - 1] == ' ' || str[end - 1] == '\t' ||
+                                 str[end - 1] == '\r'))
+            end--;
+        return str.substr(begin, end - begin);
+    }
+
+    size_t LoadGlyphWikiDump(
+        Kage& kage, std::istream& in, std::vector<std::string>* names) {
+        std::string line;
+        size_t      count = 0;
+        while(std::getline(in, line)) {
+            auto first = line.find('|');
+            if(first == std::string::npos) continue;
+            auto second = line.find('|', first + 1);
+            if(second == std::string::npos) continue;
+            auto name = DumpTrim(line, 0, first);
+            auto data = DumpTrim(line, second + 1, line.size());
+            // 表头与分隔线
+            if(name.empty() || name == "name" || name[0] == '-') continue;
+            kage.SetBuhin(name, data);
+            if(names) names->push_back(name);
+            count++;
+        }
+        return count;
+    }
+
+} // namespace Kage
@@ -1,134 +1,287 @@
 #include "export.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
-#include <iostream>
 
 #include "point.h"
+#include "stats.h"
 
 namespace Kage {
 
+    SVGSink::SVGSink(std::string& buffer): _buffer(buffer) {
+        _mode = -1;
+    }
+
+    void SVGSink::Coord(Point p) {
+        _buffer += Double2String(p.x) + "," + Double2String(p.y) + " ";
+    }
+
     // polygon.js/Polygon/get_sub_path_svg
-    std::string Contour2SVGstr(Contour contour) {
-        std::string buffer     = "M";
-        auto        firstPoint = contour.Points().at(0);
-        buffer                += Double2String(firstPoint.x) + "," +
-            Double2String(firstPoint.y) + " ";
-        ptType mode = -1;
-        for(size_t j = 1; j < contour.Points().size(); j++) {
-            if(contour.PointTypes().at(j) == PT_QUAD && mode != PT_QUAD)
-                buffer += "Q", mode = PT_QUAD;
-            else if(contour.PointTypes().at(j - 1) == PT_POINT &&
-                contour.PointTypes().at(j) == PT_CUBIC && mode != PT_CUBIC)
-                buffer += "C", mode = PT_CUBIC;
-            else if(contour.PointTypes().at(j - 1) == PT_POINT &&
-                contour.PointTypes().at(j) == PT_POINT && mode != PT_POINT)
-                buffer += "L", mode = PT_POINT;
-            buffer += Double2String(contour.Points().at(j).x) + "," +
-                Double2String(contour.Points().at(j).y) + " ";
-        }
-        if(contour.isClosed()) buffer += "Z";
-        return buffer;
+    void SVGSink::MoveTo(Point p) {
+        _buffer += "<path d=\"M";
+        Coord(p);
+        _mode = -1;
+    }
+
+    void SVGSink::LineTo(Point p) {
+        if(_mode != PT_POINT) _buffer += "L", _mode = PT_POINT;
+        Coord(p);
+    }
+
+    void SVGSink::QuadTo(Point p1, Point p2) {
+        if(_mode != PT_QUAD) _buffer += "Q", _mode = PT_QUAD;
+        Coord(p1), Coord(p2);
+    }
+
+    void SVGSink::CubicTo(Point p1, Point p2, Point p3) {
+        if(_mode != PT_CUBIC) _buffer += "C", _mode = PT_CUBIC;
+        Coord(p1), Coord(p2), Coord(p3);
+    }
+
+    void SVGSink::Close() {
+        _buffer += "Z\" fill=\"black\" />\n";
     }
 
     // polygons.js/Polygons/generateSVG
     std::string Canva2SVG(Canva canva) {
+        KAGE_STATS_SCOPE(STATS_EXPORT);
         std::string buffer =
         "<svg xmlns=\"http://www.w3.org/2000/svg\" "
         "xmlns:xlink=\"http://www.w3.org/1999/xlink\" version=\"1.1\" "
         "baseProfile=\"full\" viewBox=\"0 0 200 200\" width=\"200\" "
         "height=\"200\">\n";
-        for(auto i: canva.Contours()) {
-            try {
-                buffer +=
-                    "<path d=\"" + Contour2SVGstr(i) + "\" fill=\"black\" />\n";
-            } catch(const std::exception& e) {
-                std::cerr << "An error occured when generating spline data in "
-                             "SVG format, dropping: "
-                          << e.what() << '\n';
-            }
-        }
+        SVGSink sink(buffer);
+        canva.Replay(sink);
         buffer += "</svg>\n";
         return buffer;
     }
 
-    std::string Contour2SFDstr(Contour contour) {
-        auto        firstPoint = contour.Points().at(0);
-        std::string buffer     = Double2String(firstPoint.x * 5.25 - 25) + " " +
-            Double2String(firstPoint.y * (-5.25) + 905) + " m 1\n";
-        Point lastPoint;
-        for(size_t j = 1; j < contour.Points().size();) {
-            if(contour.PointTypes().at(j) == PT_POINT) {
-                buffer += " " +
-                    Double2String(contour.Points().at(j).x * 5.25 - 25) + " " +
-                    Double2String(contour.Points().at(j).y * (-5.25) + 905) +
-                    " l 1\n";
-                lastPoint = contour.Points().at(j);
+    std::string SFDCoord(Point p) {
+        return Double2String(p.x * 5.25 - 25) + " " +
+            Double2String(p.y * (-5.25) + 905);
+    }
+
+    SFDSink::SFDSink(std::string& buffer): _buffer(buffer) {}
+
+    // 曲线段后接曲线时标记为0，否则为1
+    void SFDSink::Flush(bool curve) {
+        if(_pending) _buffer += curve ? "0\n" : "1\n";
+        _pending = false;
+    }
+
+    void SFDSink::MoveTo(Point p) {
+        Flush(false);
+        _buffer += SFDCoord(p) + " m 1\n";
+        _first = p, _last = Point();
+    }
+
+    void SFDSink::LineTo(Point p) {
+        Flush(false);
+        _buffer += " " + SFDCoord(p) + " l 1\n";
+        _last    = p;
+    }
+
+    // 二次曲线转换为三次曲线
+    void SFDSink::QuadTo(Point p1, Point p2) {
+        Flush(true);
+        Point ps1 = _last.GetExtendedDest(p1, (p1 - _last).GetLength() / 3),
+              ps2 = p2.GetExtendedDest(p1, (p2 - p1).GetLength() / 3);
+        _buffer  += " " + SFDCoord(ps1) + " " + SFDCoord(ps2) + " " +
+            SFDCoord(p2) + " c ";
+        _last = p2, _pending = true;
+    }
+
+    void SFDSink::CubicTo(Point p1, Point p2, Point p3) {
+        Flush(true);
+        _buffer += " " + SFDCoord(p1) + " " + SFDCoord(p2) + " " +
+            SFDCoord(p3) + " c ";
+        _last = p3, _pending = true;
+    }
+
+    void SFDSink::Close() {
+        Flush(false);
+        if(_last != _first) _buffer += " " + SFDCoord(_first) + " l 1\n";
+    }
+
+    std::string Canva2SFD(Canva canva) {
+        KAGE_STATS_SCOPE(STATS_EXPORT);
+        std::string buffer = "SplineSet\n";
+        SFDSink     sink(buffer);
+        canva.Replay(sink);
+        buffer += "EndSplineSet\n";
+        return buffer;
+    }
+
+    // 紧凑SVG的输出状态，坐标均为按精度放大后的整数
+    typedef struct {
+        std::string buffer;
+        long long   scale;
+        int         precision;
+        char        lastCmd;    // 相同命令连续出现时可省略
+        bool        lastIsNum;  // 上一个输出是否为数值
+        bool        lastHasDot; // 上一个数值是否含小数点
+        long long   x, y;       // 当前点
+    } CompactSVGState;
+
+    void CompactSVGCommand(CompactSVGState& s, char cmd) {
+        if(cmd == s.lastCmd && cmd != 'z' && cmd != 'm') return;
+        s.buffer += cmd, s.lastCmd = cmd, s.lastIsNum = false;
+    }
+
+    // 输出一个数，省略前导0与末尾的0，可以省略的分隔符也不输出
+    void CompactSVGNumber(CompactSVGState& s, long long q) {
+        unsigned long long a = q < 0 ? -q : q, ip = a / s.scale,
+                           fp = a % s.scale;
+        std::string        text = q < 0 ? "-" : "";
+        if(ip != 0 || fp == 0) text += std::to_string(ip);
+        if(fp != 0) {
+            std::string frac = std::to_string(fp);
+            frac = std::string(s.precision - frac.size(), '0') + frac;
+            while(frac.back() == '0')
+                frac.pop_back();
+            text += "." + frac;
+        }
+        bool hasDot = text.find('.') != std::string::npos;
+        if(s.lastIsNum && text[0] != '-' && !(text[0] == '.' && s.lastHasDot))
+            s.buffer += ' ';
+        s.buffer += text, s.lastIsNum = true, s.lastHasDot = hasDot;
+    }
+
+    void CompactSVGContour(CompactSVGState& s, Contour contour) {
+        auto&                  pts = contour.Points();
+        auto&                  types = contour.PointTypes();
+        size_t                 n = pts.size();
+        std::vector<long long> qx(n), qy(n);
+        bool                   empty = true;
+        for(size_t i = 0; i < n; i++) {
+            qx[i] = std::llround(pts[i].x * s.scale),
+            qy[i] = std::llround(pts[i].y * s.scale);
+            if(qx[i] != qx[0] || qy[i] != qy[0]) empty = false;
+        }
+        if(empty) return;
+        bool closed = contour.isClosed();
+        CompactSVGCommand(s, 'm');
+        CompactSVGNumber(s, qx[0] - s.x), CompactSVGNumber(s, qy[0] - s.y);
+        s.x = qx[0], s.y = qy[0], s.lastCmd = 'l'; // m之后的坐标对视为l
+        char      prevType = 0;                    // 用于s与t的上一段类型
+        long long prevCx = 0, prevCy = 0;          // 上一段的最后一个控制点
+        for(size_t j = 1; j < n;) {
+            if(types[j] == PT_POINT) {
+                long long dx = qx[j] - s.x, dy = qy[j] - s.y;
                 j++;
-            } else if(j + 1 < contour.Points().size() &&
-                contour.PointTypes().at(j) == PT_QUAD) {
-                auto p1   = contour.Points().at(j),
-                     p    = contour.Points().at(j + 1);
-                Point ps1 = lastPoint.GetExtendedDest(
-                          p1, (p1 - lastPoint).GetLength() / 3),
-                      ps2 = p.GetExtendedDest(p1, (p - p1).GetLength() / 3);
-                buffer   += " " + Double2String(ps1.x * 5.25 - 25) + " " +
-                    Double2String(ps1.y * (-5.25) + 905) + " " +
-                    Double2String(ps2.x * 5.25 - 25) + " " +
-                    Double2String(ps2.y * (-5.25) + 905) + " " +
-                    Double2String(p.x * 5.25 - 25) + " " +
-                    Double2String(p.y * (-5.25) + 905) + " c ";
-                if(j + 2 < contour.PointTypes().size() &&
-                    (contour.PointTypes().at(j + 2) == PT_QUAD ||
-                        contour.PointTypes().at(j + 2) == PT_CUBIC))
-                    buffer += "0\n";
-                else
-                    buffer += "1\n";
-                lastPoint = contour.Points().at(j + 1);
-                j        += 2;
-            } else if(j + 2 < contour.Points().size() &&
-                contour.PointTypes().at(j) == PT_CUBIC) {
-                buffer += " " +
-                    Double2String(contour.Points().at(j).x * 5.25 - 25) + " " +
-                    Double2String(contour.Points().at(j).y * (-5.25) + 905) +
-                    " " +
-                    Double2String(contour.Points().at(j + 1).x * 5.25 - 25) +
-                    " " +
-                    Double2String(
-                        contour.Points().at(j + 1).y * (-5.25) + 905) +
-                    " " +
-                    Double2String(contour.Points().at(j + 2).x * 5.25 - 25) +
-                    " " +
-                    Double2String(
-                        contour.Points().at(j + 2).y * (-5.25) + 905) +
-                    " c ";
-                if(j + 3 < contour.PointTypes().size() &&
-                    (contour.PointTypes().at(j + 3) == PT_QUAD ||
-                        contour.PointTypes().at(j + 3) == PT_CUBIC))
-                    buffer += "0\n";
+                prevType = 0;
+                if(dx == 0 && dy == 0) continue;
+                // 闭合轮廓回到起点的直线由z代替
+                if(closed && j == n && qx[j - 1] == qx[0] && qy[j - 1] == qy[0])
+                    break;
+                if(dy == 0)
+                    CompactSVGCommand(s, 'h'), CompactSVGNumber(s, dx);
+                else if(dx == 0)
+                    CompactSVGCommand(s, 'v'), CompactSVGNumber(s, dy);
                 else
-                    buffer += "1\n";
-                lastPoint = contour.Points().at(j + 2);
-                j        += 3;
+                    CompactSVGCommand(s, 'l'), CompactSVGNumber(s, dx),
+                        CompactSVGNumber(s, dy);
+                s.x = qx[j - 1], s.y = qy[j - 1];
+                continue;
             }
+            bool   cubic = types[j] == PT_CUBIC && j + 1 < n &&
+                types[j + 1] == PT_CUBIC;
+            size_t e = j + (cubic ? 2 : 1);
+            if(e >= n) {
+                if(!closed || e > n) break;
+                e = 0; // 末尾的控制点连接回起点
+            }
+            size_t    c2 = cubic ? j + 1 : j;
+            long long c1x = qx[j], c1y = qy[j], c2x = qx[c2], c2y = qy[c2];
+            bool      smooth = prevType == (cubic ? 'c' : 'q') &&
+                c1x == 2 * s.x - prevCx && c1y == 2 * s.y - prevCy;
+            if(cubic && smooth)
+                CompactSVGCommand(s, 's');
+            else if(cubic)
+                CompactSVGCommand(s, 'c'), CompactSVGNumber(s, c1x - s.x),
+                    CompactSVGNumber(s, c1y - s.y);
+            else
+                CompactSVGCommand(s, smooth ? 't' : 'q');
+            if(!(!cubic && smooth))
+                CompactSVGNumber(s, c2x - s.x), CompactSVGNumber(s, c2y - s.y);
+            CompactSVGNumber(s, qx[e] - s.x), CompactSVGNumber(s, qy[e] - s.y);
+            prevType = cubic ? 'c' : 'q', prevCx = c2x, prevCy = c2y;
+            s.x = qx[e], s.y = qy[e];
+            j += cubic ? 3 : 2;
+        }
+        if(closed) {
+            CompactSVGCommand(s, 'z');
+            s.x = qx[0], s.y = qy[0];
         }
-        if(contour.isClosed() && lastPoint != firstPoint)
-            buffer += " " + Double2String(firstPoint.x * 5.25 - 25) + " " +
-                Double2String(firstPoint.y * (-5.25) + 905) + " l 1\n";
-        return buffer;
     }
 
-    std::string Canva2SFD(Canva canva) {
-        std::string buffer = "SplineSet\n";
+    std::string Canva2SVGPath(Canva canva, int precision) {
+        KAGE_STATS_SCOPE(STATS_EXPORT);
+        CompactSVGState s;
+        s.precision = std::min(std::max(precision, 0), 9);
+        s.scale     = 1;
+        for(int i = 0; i < s.precision; i++)
+            s.scale *= 10;
+        s.lastCmd = 0, s.lastIsNum = false, s.lastHasDot = false;
+        s.x = 0, s.y = 0;
+        // 合并为一个path前统一方向，否则方向相反的笔画重叠处会被挖空
         for(auto i: canva.Contours()) {
-            try {
-                buffer += Contour2SFDstr(i);
-            } catch(const std::exception& e) {
-                std::cerr << "An error occured when generating spline data in "
-                             "SFD format, dropping: "
-                          << e.what() << '\n';
-            }
+            i.NormalizeOrientation();
+            CompactSVGContour(s, i);
         }
-        buffer += "EndSplineSet\n";
+        return s.buffer;
+    }
+
+    std::string Canva2CompactSVG(Canva canva, int precision) {
+        return "<svg xmlns=\"http://www.w3.org/2000/svg\" "
+               "viewBox=\"0 0 200 200\" width=\"200\" height=\"200\">"
+               "<path d=\"" +
+            Canva2SVGPath(canva, precision) + "\"/></svg>\n";
+    }
+
+    std::string CompactSVGEscape(std::string text) {
+        std::string result;
+        for(auto c: text) {
+            if(c == '&')
+                result += "&amp;";
+            else if(c == '<')
+                result += "&lt;";
+            else if(c == '>')
+                result += "&gt;";
+            else if(c == '"')
+                result += "&quot;";
+            else
+                result += c;
+        }
+        return result;
+    }
+
+    std::string Canva2SVGSprite(
+        std::vector<std::pair<std::string, Canva>> glyphs, int precision,
+        size_t columns) {
+        size_t cols = std::min(columns, glyphs.size()),
+               rows = cols == 0 ? 0 : (glyphs.size() + cols - 1) / cols;
+        std::string width = std::to_string(200 * cols),
+                    height = std::to_string(200 * rows);
+        std::string buffer = "<svg xmlns=\"http://www.w3.org/2000/svg\" "
+                             "xmlns:xlink=\"http://www.w3.org/1999/xlink\"";
+        if(columns != 0)
+            buffer += " viewBox=\"0 0 " + width + " " + height +
+                "\" width=\"" + width + "\" height=\"" + height + "\"";
+        buffer += "><defs>";
+        for(auto& i: glyphs)
+            buffer += "<symbol id=\"" + CompactSVGEscape(i.first) +
+                "\" viewBox=\"0 0 200 200\"><path d=\"" +
+                Canva2SVGPath(i.second, precision) + "\"/></symbol>";
+        buffer += "</defs>";
+        for(size_t i = 0; columns != 0 && i < glyphs.size(); i++)
+            buffer += "<use xlink:href=\"#" +
+                CompactSVGEscape(glyphs[i].first) + "\" x=\"" +
+                std::to_string(200 * (i % columns)) + "\" y=\"" +
+                std::to_string(200 * (i / columns)) +
+                "\" width=\"200\" height=\"200\"/>";
+        buffer += "</svg>\n";
         return buffer;
     }
 
@@ -1,4 +1,6 @@
 #include "fitcurve.h"
+#include "stats.h"
+#include "trace.h"
 
 namespace Kage {
 
@@ -213,6 +215,8 @@ namespace Kage {
     // Fit a Bezier curve to a set of digitized points
     std::vector<CubicSpline> FitCurve(
         std::vector<Point> points, double maxError) {
+        KAGE_TRACE_SCOPE("FitCurve");
+        KAGE_STATS_SCOPE(STATS_CURVE_FIT);
         std::vector<CubicSpline> pp;
         FitCubic(points, 0, points.size() - 1,
             (points[1] - points[0])
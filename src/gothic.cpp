@@ -2,6 +2,7 @@
 
 #include "bezier.h"
 #include "gothic.h"
+#include "trace.h"
 
 namespace Kage {
 
@@ -9,7 +10,7 @@ namespace Kage {
     const auto BEZ_CIR    = 4 * (std::sqrt(2) - 1) / 3;
 
     // gothic.js/Gothic/constructor
-    Gothic::Gothic(double size) {
+    Gothic::Gothic(double size): KageFont(size) {
         _type = KAGEFONT_GOTHIC;
         if(size == 1)
             kWidth = 3, kKakato = 1.8, kMage = 6;
@@ -181,12 +182,22 @@ namespace Kage {
     }
 
     // gothic.js/Gothic/getPolygons
-    Canva Gothic::DrawGlyph(std::vector<Stroke> strokes) {
-        Canva cv;
-        for(auto stroke: strokes) {
+    void Gothic::DrawStrokeInGlyph(
+        Canva& cv, std::vector<Stroke> const& strokes, size_t index) {
+        auto& stroke = strokes[index];
+        KAGE_TRACE_SCOPE_ARG("DrawStroke", std::to_string(stroke.type));
+        // 翻转、旋转作用于整个画布，不可记忆
+        if(stroke.type == STROKE_SPECIAL)
             DrawStroke(cv, stroke);
-        }
-        return cv;
+        else
+            DrawMemoized(cv, _strokeMemo, StrokeMemoKey(stroke),
+                [&](Canva& c) { DrawStroke(c, stroke); });
+    }
+
+    // 笔画的绘制不依赖其他笔画
+    bool Gothic::IsIsolated(
+        std::vector<Stroke> const&, size_t, size_t) {
+        return true;
     }
 
 } // namespace Kage
@@ -1,9 +1,11 @@
 #include <cmath>
 #include <cstdio>
 #include <exception>
+#include <type_traits>
 
 #include "gwdata.h"
 #include "point.h"
+#include "stats.h"
 
 namespace Kage {
 
@@ -33,7 +35,11 @@ namespace Kage {
         return out;
     }
 
-    bool StrokeParse(std::string strokeStr, Stroke& stroke) {
+    static_assert(std::is_trivially_copyable<Stroke>::value,
+        "Stroke should be copied with memcpy");
+
+    bool StrokeParse(
+        std::string strokeStr, Stroke& stroke, SymbolTable& symbols) {
         auto splited = StringSplit(strokeStr, U':');
         if(splited.size() < 4) return false;
         StrokeType strokeType;
@@ -66,8 +72,9 @@ namespace Kage {
             } catch(const std::exception& e) {
                 ;
             }
-            stroke.buhin = splited[7], stroke.p1 = Point(x1, y1),
-            stroke.p2 = Point(x2, y2), stroke.s1 = Point(sx, sy),
+            stroke.buhin = symbols.Intern(splited[7]),
+            stroke.p1 = Point(x1, y1), stroke.p2 = Point(x2, y2),
+            stroke.s1 = Point(sx, sy),
             stroke.s2 = Point(sx2, sy2);
             break;
         case STROKE_SPECIAL:
@@ -154,7 +161,7 @@ namespace Kage {
         return true;
     }
 
-    std::string StrokeToString(Stroke stroke) {
+    std::string StrokeToString(Stroke stroke, SymbolTable& symbols) {
         std::string out;
         out = Double2String(stroke.type) + ":";
         switch(stroke.type) {
@@ -164,7 +171,7 @@ namespace Kage {
                 Double2String(stroke.s1.y) + ":" + Double2String(stroke.p1.x) +
                 ":" + Double2String(stroke.p1.y) + ":" +
                 Double2String(stroke.p2.x) + ":" + Double2String(stroke.p2.y) +
-                ":" + stroke.buhin;
+                ":" + symbols.Name(stroke.buhin);
             if(stroke.s2.isVaild())
                 out += ":0:" + Double2String(stroke.s2.x) + ":" +
                     Double2String(stroke.s2.y);
@@ -194,20 +201,40 @@ namespace Kage {
         return out;
     }
 
-    std::vector<Stroke> StrokesParse(std::string glyphData) {
+    std::vector<Stroke> StrokesParse(
+        std::string glyphData, SymbolTable& symbols) {
+        KAGE_STATS_SCOPE(STATS_PARSE);
         std::vector<Stroke> strokes;
         auto                textData = StringSplit2(glyphData, U'$', U'\n');
         for(auto i: textData) {
             Stroke stroke;
-            if(StrokeParse(i, stroke)) strokes.push_back(stroke);
+            stroke.buhin = 0;
+            if(StrokeParse(i, stroke, symbols)) strokes.push_back(stroke);
         }
         return strokes;
     }
 
-    std::string StrokesToString(std::vector<Stroke> strokes, char32_t sep) {
+    // 只取出引用的部件名，不解析笔画
+    std::vector<std::string> StrokesReferences(std::string glyphData) {
+        std::vector<std::string> names;
+        for(auto i: StringSplit2(glyphData, U'$', U'\n')) {
+            auto splited = StringSplit(i, U':');
+            if(splited.size() < 8) continue;
+            try {
+                if(std::stoull(splited[0]) % 100 != STROKE_REFERENCE) continue;
+            } catch(const std::exception& e) {
+                continue;
+            }
+            names.push_back(splited[7]);
+        }
+        return names;
+    }
+
+    std::string StrokesToString(
+        std::vector<Stroke> strokes, char32_t sep, SymbolTable& symbols) {
         std::string out;
         for(auto it = strokes.begin(); it != strokes.end(); ++it) {
-            out += StrokeToString(*it);
+            out += StrokeToString(*it, symbols);
             if(it != strokes.end() - 1) out += sep;
         }
         return out;
@@ -225,8 +252,16 @@ namespace Kage {
 
     // util.js/getBoundingBox
     BoundingData GetBoundingBox(std::vector<Stroke> strokes) {
+        return GetBoundingBox(strokes, 0, strokes.size());
+    }
+
+    // 只计算strokes[begin, end)，不复制笔画
+    BoundingData GetBoundingBox(
+        std::vector<Stroke> const& strokes, size_t begin, size_t end) {
+        KAGE_STATS_SCOPE(STATS_TRANSFORM);
         BoundingData a = {minX: 200, minY: 200, maxX: 0, maxY: 0};
-        for(auto i: strokes) {
+        for(size_t k = begin; k < end; k++) {
+            auto& i = strokes[k];
             if(i.type == STROKE_SPECIAL) continue;
             a.minX = std::min(a.minX, i.p1.x),
             a.maxX = std::max(a.maxX, i.p1.x);
@@ -253,6 +288,51 @@ namespace Kage {
         return a;
     }
 
+    // 对strokes[begin, end)依次应用steps中的变换，从最后一个（最内层）开始
+    // 与kage.js逐层计算的结果完全相同：各步不合并，以免Stretch取整时产生差异
+    // 坐标先按轴收集到连续的数组中，每一步都是可向量化的循环
+    void TransformStrokes(std::vector<Stroke>& strokes, size_t begin,
+        size_t end, std::vector<BuhinTransform> const& steps) {
+        if(begin >= end || steps.empty()) return;
+        KAGE_STATS_SCOPE(STATS_TRANSFORM);
+        size_t              n = (end - begin) * 4;
+        std::vector<double> xs(n), ys(n);
+        for(size_t i = begin, j = 0; i < end; i++, j += 4) {
+            auto& s = strokes[i];
+            xs[j] = s.p1.x, xs[j + 1] = s.p2.x, xs[j + 2] = s.p3.x,
+            xs[j + 3] = s.p4.x;
+            ys[j] = s.p1.y, ys[j + 1] = s.p2.y, ys[j + 2] = s.p3.y,
+            ys[j + 3] = s.p4.y;
+        }
+        for(auto it = steps.rbegin(); it != steps.rend(); ++it) {
+            auto& t = *it;
+            if(!t.stretch) {
+                double ax = t.p1.x, dx = t.p2.x - t.p1.x;
+                double ay = t.p1.y, dy = t.p2.y - t.p1.y;
+                for(size_t j = 0; j < n; j++)
+                    xs[j] = ax + xs[j] * dx / 200;
+                for(size_t j = 0; j < n; j++)
+                    ys[j] = ay + ys[j] * dy / 200;
+                continue;
+            }
+            // 引用笔画的p3、p4不参与拉伸
+            for(size_t i = begin, j = 0; i < end; i++, j += 4) {
+                size_t last = strokes[i].type == STROKE_REFERENCE ? 2 : 4;
+                for(size_t k = j; k < j + last; k++)
+                    xs[k] =
+                        Stretch(t.dp.x, t.sp.x, xs[k], t.box.minX, t.box.maxX),
+                    ys[k] =
+                        Stretch(t.dp.y, t.sp.y, ys[k], t.box.minY, t.box.maxY);
+            }
+        }
+        for(size_t i = begin, j = 0; i < end; i++, j += 4) {
+            auto& s = strokes[i];
+            s.p1 = Point(xs[j], ys[j]), s.p2 = Point(xs[j + 1], ys[j + 1]),
+            s.p3 = Point(xs[j + 2], ys[j + 2]),
+            s.p4 = Point(xs[j + 3], ys[j + 3]);
+        }
+    }
+
     // 2d.js/getCrossPoint
     Point GetCrossPoint(Point p11, Point p12, Point p21, Point p22) {
         double a1 = p12.y - p11.y, b1 = p11.x - p12.x,
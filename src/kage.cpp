@@ -1,99 +1,214 @@
 #include "kage.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+
 #include "gothic.h"
 #include "mincho.h"
+#include "stats.h"
+#include "trace.h"
 
 namespace Kage {
 
     thread_local std::unordered_set<std::string> Kage::_glyphStack;
 
     // kage.js/Kage/constructor
-    Kage::Kage(KageFontType font, double size) {
+    Kage::Kage(
+        KageFontType font, double size, std::shared_ptr<SymbolTable> symbols) {
         SetFont(font, size);
-        _kRate = 100;
+        _kRate   = 100;
+        _symbols = symbols ? symbols : DefaultSymbolTable();
+    }
+
+    std::shared_ptr<SymbolTable> Kage::GetSymbolTable() {
+        return _symbols;
     }
 
     // kage.js/Kage/getStrokes
-    std::vector<Stroke> Kage::GetStrokes(std::vector<Stroke> glyphData) {
-        std::vector<Stroke> strokes;
-        for(auto stroke: glyphData) {
-            if(stroke.type != STROKE_REFERENCE)
-                strokes.push_back(stroke);
-            else {
-                std::vector<Stroke> buhin = SearchBuhin(stroke.buhin), temp;
-                if(!buhin.empty())
-                    temp = GetStrokesOfBuhin(
-                        buhin, stroke.p1, stroke.p2, stroke.s1, stroke.s2);
-                else
-                    temp = _notDefGlyph;
-                for(auto t: temp)
-                    strokes.push_back(t);
-            }
-        }
+    // groups不为空时记录每个直接引用的部件展开后的笔画范围
+    std::vector<Stroke> Kage::GetStrokes(BuhinSnapshot const& db,
+        std::vector<Stroke> const& glyphData, std::vector<StrokeGroup>* groups) {
+        std::vector<Stroke>         strokes;
+        std::vector<BuhinTransform> transforms;
+        GetStrokesOfBuhin(db, glyphData, transforms, strokes, groups);
         return strokes;
     }
 
     // kage.js/Kage/getStrokesOfBuhin
-    std::vector<Stroke> Kage::GetStrokesOfBuhin(
-        std::vector<Stroke> buhin, Point p1, Point p2, Point ps, Point ps2) {
-        auto                temp = GetStrokes(buhin);
-        std::vector<Stroke> result;
-        auto                box = GetBoundingBox(temp);
-        if(ps.x != 0 || ps.y != 0) {
-            if(ps.x > 100)
-                ps.x -= 200;
-            else
-                ps2 = Point(0, 0);
-        }
-        for(auto& t: temp) {
-            if(ps.x != 0 || ps.y != 0) {
-                t.p1.x = Stretch(ps.x, ps2.x, t.p1.x, box.minX, box.maxX),
-                t.p1.y = Stretch(ps.y, ps2.y, t.p1.y, box.minY, box.maxY),
-                t.p2.x = Stretch(ps.x, ps2.x, t.p2.x, box.minX, box.maxX),
-                t.p2.y = Stretch(ps.y, ps2.y, t.p2.y, box.minY, box.maxY);
-                if(t.type != STROKE_REFERENCE)
-                    t.p3.x = Stretch(ps.x, ps2.x, t.p3.x, box.minX, box.maxX),
-                    t.p3.y = Stretch(ps.y, ps2.y, t.p3.y, box.minY, box.maxY),
-                    t.p4.x = Stretch(ps.x, ps2.x, t.p4.x, box.minX, box.maxX),
-                    t.p4.y = Stretch(ps.y, ps2.y, t.p4.y, box.minY, box.maxY);
+    // 展开glyphData并追加到result，transforms为外层各部件累积的变换
+    // 笔画不逐层复制，而是在叶子处一次应用所有外层变换；只有带拉伸参数的
+    // 部件需要先得到内部笔画的包围盒，此时先展开到自身坐标再继续变换
+    void Kage::GetStrokesOfBuhin(BuhinSnapshot const& db,
+        std::vector<Stroke> const&                    glyphData,
+        std::vector<BuhinTransform>& transforms, std::vector<Stroke>& result,
+        std::vector<StrokeGroup>* groups) {
+        size_t pending = result.size(); // 尚未变换的直属笔画
+        for(auto& stroke: glyphData) {
+            if(stroke.type != STROKE_REFERENCE) {
+                result.push_back(stroke);
+                continue;
             }
-            t.p1.x = p1.x + t.p1.x * (p2.x - p1.x) / 200,
-            t.p1.y = p1.y + t.p1.y * (p2.y - p1.y) / 200,
-            t.p2.x = p1.x + t.p2.x * (p2.x - p1.x) / 200,
-            t.p2.y = p1.y + t.p2.y * (p2.y - p1.y) / 200,
-            t.p3.x = p1.x + t.p3.x * (p2.x - p1.x) / 200,
-            t.p3.y = p1.y + t.p3.y * (p2.y - p1.y) / 200,
-            t.p4.x = p1.x + t.p4.x * (p2.x - p1.x) / 200,
-            t.p4.y = p1.y + t.p4.y * (p2.y - p1.y) / 200;
-            result.push_back(t);
+            KAGE_TRACE_SCOPE_ARG(
+                "GetStrokesOfBuhin", _symbols->Name(stroke.buhin));
+            auto   buhin = SearchBuhinId(db, stroke.buhin);
+            size_t first = result.size();
+            if(buhin.empty()) {
+                result.insert(
+                    result.end(), _notDefGlyph.begin(), _notDefGlyph.end());
+                if(groups && result.size() > first)
+                    groups->push_back({first, result.size()});
+                continue;
+            }
+            TransformStrokes(result, pending, result.size(), transforms);
+            BuhinTransform affine;
+            affine.stretch = false, affine.p1 = stroke.p1,
+            affine.p2 = stroke.p2;
+            Point ps = stroke.s1, ps2 = stroke.s2;
+            if(ps.x == 0 && ps.y == 0) {
+                transforms.push_back(affine);
+                GetStrokesOfBuhin(db, buhin, transforms, result);
+                transforms.pop_back();
+            } else {
+                if(ps.x > 100)
+                    ps.x -= 200;
+                else
+                    ps2 = Point(0, 0);
+                size_t                      begin = result.size();
+                std::vector<BuhinTransform> inner;
+                GetStrokesOfBuhin(db, buhin, inner, result);
+                BuhinTransform stretch;
+                stretch.stretch = true, stretch.dp = ps, stretch.sp = ps2;
+                stretch.box = GetBoundingBox(result, begin, result.size());
+                transforms.push_back(affine), transforms.push_back(stretch);
+                TransformStrokes(result, begin, result.size(), transforms);
+                transforms.pop_back(), transforms.pop_back();
+            }
+            if(groups && result.size() > first)
+                groups->push_back({first, result.size()});
+            pending = result.size();
+        }
+        TransformStrokes(result, pending, result.size(), transforms);
+    }
+
+    // 更新反向引用索引，并将name及引用它的字形标记为需要重新生成
+    // 调用时须持有_writeMutex
+    void Kage::UpdateDependency(uint32_t id,
+        std::vector<Stroke> const& oldData,
+        std::vector<Stroke> const& newData) {
+        for(auto& i: oldData) {
+            if(i.type != STROKE_REFERENCE) continue;
+            auto it = _dependentDB.find(i.buhin);
+            if(it == _dependentDB.end()) continue;
+            it->second.erase(id);
+            if(it->second.empty()) _dependentDB.erase(it);
+        }
+        for(auto& i: newData)
+            if(i.type == STROKE_REFERENCE) _dependentDB[i.buhin].insert(id);
+        _dirtyGlyphs.insert(id);
+        std::vector<uint32_t> stack = {id};
+        while(!stack.empty()) {
+            auto it = _dependentDB.find(stack.back());
+            stack.pop_back();
+            if(it == _dependentDB.end()) continue;
+            for(auto i: it->second)
+                if(_dirtyGlyphs.insert(i).second) stack.push_back(i);
         }
-        return result;
     }
 
     // buhin.js/Buhin/set
     void Kage::SetBuhin(std::string name, std::vector<Stroke> data) {
-        _kageDB[name] = data;
+        auto                        id = _symbols->Intern(name);
+        std::lock_guard<std::mutex> lock(_writeMutex);
+        auto                        old = _kageDB.Snapshot().Find(id);
+        UpdateDependency(id, old ? *old : std::vector<Stroke>(), data);
+        _kageDB.Set(id, name, data);
     }
 
     void Kage::SetBuhin(std::string name, std::string data) {
-        SetBuhin(name, StrokesParse(data));
+        SetBuhin(name, StrokesParse(data, *_symbols));
     }
 
     // buhin.js/Buhin/push
     void Kage::PushBuhin(std::string name, std::vector<Stroke> data) {
-        _kageDB.insert({name, data});
+        auto                        id = _symbols->Intern(name);
+        std::lock_guard<std::mutex> lock(_writeMutex);
+        if(_kageDB.Insert(id, name, data)) UpdateDependency(id, {}, data);
     }
 
     void Kage::PushBuhin(std::string name, std::string data) {
-        PushBuhin(name, StrokesParse(data));
+        PushBuhin(name, StrokesParse(data, *_symbols));
+    }
+
+    // 直接或间接引用name的所有字形（仅限已存入的部件）
+    std::vector<std::string> Kage::GetDependents(std::string name) {
+        std::vector<std::string>    result;
+        uint32_t                    id;
+        std::lock_guard<std::mutex> lock(_writeMutex);
+        if(!_symbols->Find(name, id)) return result;
+        std::unordered_set<uint32_t> visited = {id};
+        std::vector<uint32_t>        stack   = {id};
+        while(!stack.empty()) {
+            auto it = _dependentDB.find(stack.back());
+            stack.pop_back();
+            if(it == _dependentDB.end()) continue;
+            for(auto i: it->second) {
+                if(!visited.insert(i).second) continue;
+                result.push_back(_symbols->Name(i));
+                stack.push_back(i);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    // 取出上次调用以来被修改或受修改影响的字形，并清空记录
+    std::vector<std::string> Kage::TakeDirtyGlyphs() {
+        std::vector<std::string>    result;
+        std::lock_guard<std::mutex> lock(_writeMutex);
+        for(auto i: _dirtyGlyphs)
+            result.push_back(_symbols->Name(i));
+        _dirtyGlyphs.clear();
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    // 引用笔画中的部件直接按编号查找，本地没有时才转换为名称查询
+    std::vector<Stroke> Kage::SearchBuhinId(
+        BuhinSnapshot const& db, uint32_t id) {
+        {
+            KAGE_STATS_SCOPE(STATS_RESOLVE);
+            auto data = db.Find(id);
+            if(data) return *data;
+            if(!_dbSearchCallback && !_dbBatchSearchCallback) return {};
+        }
+        return SearchBuhin(db, _symbols->Name(id));
     }
 
     // buhin.js/Buhin/search
     std::vector<Stroke> Kage::SearchBuhin(std::string name) {
-        if(_kageDB.find(name) != _kageDB.end())
-            return _kageDB.at(name);
-        else if(_dbSearchCallback) {
-            return StrokesParse(_dbSearchCallback(name));
+        return SearchBuhin(_kageDB.Snapshot(), name);
+    }
+
+    std::vector<Stroke> Kage::SearchBuhin(
+        BuhinSnapshot const& db, std::string name) {
+        KAGE_STATS_SCOPE(STATS_RESOLVE);
+        auto data = db.Find(name);
+        if(data)
+            return *data;
+        else if(_dbSearchCallback || _dbBatchSearchCallback) {
+            auto search = [this](std::string name) {
+                KAGE_TRACE_SCOPE_ARG("DBSearch", name);
+                if(_dbSearchCallback)
+                    return StrokesParse(_dbSearchCallback(name), *_symbols);
+                auto data = _dbBatchSearchCallback({name});
+                return data.empty() ? std::vector<Stroke>()
+                                    : StrokesParse(data[0], *_symbols);
+            };
+            auto cache = std::atomic_load(&_dbSearchCache);
+            if(cache) return cache->Fetch(name, search);
+            return search(name);
         } else
             return {};
     }
@@ -107,56 +222,465 @@ namespace Kage {
         }
     }
 
+    std::shared_ptr<KageFont> Kage::GetFont() {
+        return _pkFont;
+    }
+
     void Kage::SetDBsearchCallback(DBsearchCallbackFunc callback) {
         _dbSearchCallback = callback;
     }
 
+    void Kage::SetDBbatchSearchCallback(DBbatchSearchCallbackFunc callback) {
+        _dbBatchSearchCallback = callback;
+    }
+
+    // 未设置批量查询时逐个调用单个查询，都未设置时返回空函数
+    DBbatchSearchCallbackFunc Kage::BatchSearch() {
+        auto batch = _dbBatchSearchCallback;
+        if(!batch && _dbSearchCallback) {
+            auto search = _dbSearchCallback;
+            batch       = [search](std::vector<std::string> names) {
+                std::vector<std::string> data;
+                for(auto& i: names)
+                    data.push_back(search(i));
+                return data;
+            };
+        }
+        return batch;
+    }
+
+    // 缓存数据库查询的结果（包括查询不到的部件）
+    // 可与绘制同时调用，与部件数据库的快照一样以原子操作发布
+    void Kage::SetDBsearchCache(std::shared_ptr<DBsearchCache> cache) {
+        std::atomic_store(&_dbSearchCache, cache);
+    }
+
+    // 从names开始逐层批量查询引用的部件，存入SetDBsearchCache设置的缓存
+    // 每层只调用一次批量查询，下一层的查询与本层的解析同时进行
+    // 预取的结果（包括查询不到的部件）按该缓存的容量与有效期保留，因此
+    // 未设置缓存时不做任何查询，返回0
+    // 返回值为查询到的部件数；本地部件以调用时的快照为准
+    std::future<size_t> Kage::PrefetchBuhin(std::vector<std::string> names) {
+        auto cache = std::atomic_load(&_dbSearchCache);
+        if(!cache) {
+            std::promise<size_t> none;
+            none.set_value(0);
+            return none.get_future();
+        }
+        auto batch = BatchSearch();
+        // 后台任务只使用复制的值，不访问Kage对象，可在其析构后继续运行
+        auto db      = _kageDB.Snapshot();
+        auto symbols = _symbols;
+        return std::async(std::launch::async, [symbols, db, cache, batch,
+                                                  names]() {
+            std::unordered_set<std::string> visited;
+            size_t                          fetched = 0;
+            // 本地已有或已缓存的部件不需查询，但其引用的部件仍需检查
+            std::function<void(std::string, std::vector<std::string>&)>
+                enqueue = [&](std::string name,
+                              std::vector<std::string>& level) {
+                    if(!visited.insert(name).second) return;
+                    std::vector<Stroke> strokes;
+                    auto                data = db.Find(name);
+                    if(data)
+                        strokes = *data;
+                    else if(!cache->Peek(name, strokes)) {
+                        level.push_back(name);
+                        return;
+                    }
+                    for(auto& s: strokes)
+                        if(s.type == STROKE_REFERENCE)
+                            enqueue(symbols->Name(s.buhin), level);
+                };
+            std::vector<std::string> level;
+            for(auto& i: names)
+                enqueue(i, level);
+            if(!batch) return fetched;
+            std::future<std::vector<std::string>> pending;
+            if(!level.empty())
+                pending = std::async(std::launch::async, batch, level);
+            while(!level.empty()) {
+                auto data = pending.get();
+                // 批量查询返回的结果不足时，缺少的部分不缓存
+                if(data.size() > level.size()) data.resize(level.size());
+                std::vector<std::string> next;
+                for(auto& i: data)
+                    for(auto& j: StrokesReferences(i))
+                        enqueue(j, next);
+                if(!next.empty())
+                    pending = std::async(std::launch::async, batch, next);
+                for(size_t i = 0; i < data.size(); i++) {
+                    auto strokes = StrokesParse(data[i], *symbols);
+                    if(!strokes.empty()) fetched++;
+                    cache->Put(level[i], strokes);
+                }
+                level.swap(next);
+            }
+            return fetched;
+        });
+    }
+
     void Kage::SetNotDefGlyph(std::vector<Stroke> glyph) {
         _notDefGlyph = glyph;
     }
 
+    // 设置后MakeGlyph会先查找缓存，命中时不再绘制
+    void Kage::SetRenderCache(std::shared_ptr<RenderCache> cache) {
+        _renderCache = cache;
+    }
+
     // kage.js/Kage/makeGlyph
     // The word "buhin" means "component".  This method converts buhin (KAGE
     // data format) to polygons (path data).  The variable buhin may represent a
     // component of kanji or a kanji itself.
     void Kage::MakeGlyph(Canva& canva, std::string buhin) {
-        auto glyphData = SearchBuhin(buhin);
+        KAGE_TRACE_SCOPE_ARG("MakeGlyph", buhin);
+        auto db        = _kageDB.Snapshot();
+        auto glyphData = SearchBuhin(db, buhin);
         if(glyphData.empty()) glyphData = _notDefGlyph;
-        MakeGlyph2(canva, glyphData);
+        MakeGlyph2(db, canva, glyphData);
     }
 
     // kage.js/Kage/makeGlyph2
     void Kage::MakeGlyph2(Canva& canva, std::vector<Stroke> data) {
-        auto kageStrokes = GetStrokes(data);
-        canva.Concat(_pkFont->DrawGlyph(kageStrokes));
+        MakeGlyph2(_kageDB.Snapshot(), canva, data);
+    }
+
+    void Kage::MakeGlyph2(BuhinSnapshot const& db, Canva& canva,
+        std::vector<Stroke> const& data) {
+        KAGE_STATS_SCOPE(STATS_GLYPH);
+        std::vector<StrokeGroup> groups;
+        auto                     kageStrokes = GetStrokes(db, data, &groups);
+        if(!_renderCache)
+            canva.Concat(_pkFont->DrawGlyph(kageStrokes, groups));
+        else
+            canva.Concat(DrawCached(kageStrokes, groups));
+    }
+
+    void Kage::MakeGlyph(PathSink& sink, std::string buhin) {
+        KAGE_TRACE_SCOPE_ARG("MakeGlyph", buhin);
+        auto db        = _kageDB.Snapshot();
+        auto glyphData = SearchBuhin(db, buhin);
+        if(glyphData.empty()) glyphData = _notDefGlyph;
+        MakeGlyph2(db, sink, glyphData);
+    }
+
+    void Kage::MakeGlyph2(PathSink& sink, std::vector<Stroke> data) {
+        MakeGlyph2(_kageDB.Snapshot(), sink, data);
+    }
+
+    void Kage::MakeGlyph2(BuhinSnapshot const& db, PathSink& sink,
+        std::vector<Stroke> const& data) {
+        KAGE_STATS_SCOPE(STATS_GLYPH);
+        std::vector<StrokeGroup> groups;
+        auto                     kageStrokes = GetStrokes(db, data, &groups);
+        if(!_renderCache)
+            _pkFont->DrawGlyph(kageStrokes, sink, groups);
+        else
+            DrawCached(kageStrokes, groups).Replay(sink);
+    }
+
+    // 查找渲染缓存，未命中时绘制并存入
+    Canva Kage::DrawCached(std::vector<Stroke> const& kageStrokes,
+        std::vector<StrokeGroup> const& groups) {
+        auto  hash = GlyphHash(kageStrokes, _pkFont->GetType(),
+             _pkFont->GetSize(), *_symbols);
+        Canva result;
+        if(!_renderCache->Get(hash, result)) {
+            result = _pkFont->DrawGlyph(kageStrokes, groups);
+            _renderCache->Put(hash, result);
+        }
+        return result;
     }
 
     std::vector<Stroke> Kage::ExtractGlyph(std::string buhin) {
-        return ExtractGlyph2(SearchBuhin(buhin));
+        auto db = _kageDB.Snapshot();
+        return GetStrokes(db, SearchBuhin(db, buhin));
     }
 
     std::vector<Stroke> Kage::ExtractGlyph2(std::vector<Stroke> data) {
-        return GetStrokes(data);
+        return GetStrokes(_kageDB.Snapshot(), data);
     }
 
     CheckGlyphState Kage::CheckGlyph(std::string buhin) {
+        return CheckGlyph(_kageDB.Snapshot(), buhin);
+    }
+
+    CheckGlyphState Kage::CheckGlyph(
+        BuhinSnapshot const& db, std::string buhin) {
         if(_glyphStack.find(buhin) != _glyphStack.end())
             return CHECK_LOOPBACK_DETECTED;
         _glyphStack.insert(buhin);
-        auto            glyphData = SearchBuhin(buhin);
+        auto            glyphData = SearchBuhin(db, buhin);
         CheckGlyphState out;
         if(glyphData.empty())
             out = CHECK_BUHIN_NOTFOUND;
         else
-            out = CheckGlyph2(glyphData);
+            out = CheckGlyph2(db, glyphData);
         _glyphStack.erase(buhin);
         return out;
     }
 
+    // 从root开始的迭代DFS，只求出各节点的状态
+    // memo为各线程共享的结果（状态加1，0为尚未完成），已完成的节点不再进入；
+    // 其他线程正在访问的节点在本线程中重新访问，onStack只记录本线程的栈
+    void CheckFrom(std::vector<std::vector<size_t>> const& children,
+        std::vector<CheckGlyphState> const& direct, size_t root,
+        std::vector<std::atomic<uint8_t>>& memo, std::vector<uint8_t>& onStack) {
+        struct Frame {
+            size_t          node, next; // 节点与下一个子节点
+            CheckGlyphState state;
+        };
+        if(memo[root].load(std::memory_order_acquire)) return;
+        std::vector<Frame> stack = {{root, 0, direct[root]}};
+        onStack[root]            = 1;
+        while(!stack.empty()) {
+            auto& top = stack.back();
+            if(top.next < children[top.node].size()) {
+                auto    child = children[top.node][top.next++];
+                uint8_t done  = memo[child].load(std::memory_order_acquire);
+                if(done)
+                    top.state =
+                        std::max(top.state, (CheckGlyphState)(done - 1));
+                else if(onStack[child])
+                    top.state = CHECK_LOOPBACK_DETECTED;
+                else {
+                    onStack[child] = 1;
+                    stack.push_back({child, 0, direct[child]});
+                }
+            } else {
+                auto node  = top.node;
+                auto state = top.state;
+                memo[node].store(state + 1, std::memory_order_release);
+                onStack[node] = 0;
+                stack.pop_back();
+                if(!stack.empty())
+                    stack.back().state = std::max(stack.back().state, state);
+            }
+        }
+    }
+
+    // 在能到达循环的节点之间按编号顺序做三色DFS，每条返回边记录一个循环
+    // 能到达这些节点的节点同样能到达循环，所以找到的循环与在整个引用图上
+    // 按编号顺序DFS时相同
+    void CheckCycles(std::vector<std::vector<size_t>> const& children,
+        std::vector<CheckGlyphState> const& states,
+        std::vector<std::vector<size_t>>&  cycles) {
+        const uint8_t WHITE = 0, GRAY = 1, BLACK = 2;
+        size_t               n = states.size();
+        std::vector<uint8_t> colors(n, WHITE);
+        std::vector<size_t>  position(n, 0);
+        std::vector<std::pair<size_t, size_t>> stack; // 节点与下一个子节点
+        for(size_t root = 0; root < n; root++) {
+            if(states[root] != CHECK_LOOPBACK_DETECTED || colors[root] != WHITE)
+                continue;
+            colors[root] = GRAY, position[root] = 0;
+            stack.push_back({root, 0});
+            while(!stack.empty()) {
+                auto& top  = stack.back();
+                auto  node = top.first;
+                if(top.second < children[node].size()) {
+                    auto child = children[node][top.second++];
+                    if(states[child] != CHECK_LOOPBACK_DETECTED) continue;
+                    if(colors[child] == WHITE) {
+                        colors[child]   = GRAY;
+                        position[child] = stack.size();
+                        stack.push_back({child, 0});
+                    } else if(colors[child] == GRAY) {
+                        std::vector<size_t> cycle;
+                        for(auto i = position[child]; i < stack.size(); i++)
+                            cycle.push_back(stack[i].first);
+                        cycle.push_back(child);
+                        cycles.push_back(cycle);
+                    }
+                } else {
+                    colors[node] = BLACK;
+                    stack.pop_back();
+                }
+            }
+        }
+    }
+
+    // 一次检查数据库中的所有字形，每个部件只访问一次
+    // 设置了查询函数时，本地没有的部件按引用的层次逐层查询，每层只调用一次
+    // 批量查询（结果存入SetDBsearchCache设置的缓存）
+    // 以每个字形为起点分配到threads个线程（为0时使用CPU核心数），各线程共享
+    // 已完成部件的结果，最后在能到达循环的部件之间找出所有循环
+    CheckReport Kage::CheckAllGlyphs(size_t threads) {
+        CheckReport                                    report;
+        auto                                          db = _kageDB.Snapshot();
+        std::vector<std::pair<std::string, uint32_t>> local;
+        for(auto i: db.Ids())
+            local.push_back({_symbols->Name(i), i});
+        std::sort(local.begin(), local.end());
+        std::vector<std::string>                names;
+        std::vector<BuhinData>                  localData;
+        std::vector<std::vector<Stroke> const*> data;
+        std::unordered_map<uint32_t, size_t>    ids;
+        for(auto& i: local) {
+            ids[i.second] = names.size();
+            names.push_back(i.first), localData.push_back(db.Find(i.second));
+            data.push_back(localData.back().get());
+        }
+
+        std::deque<std::vector<Stroke>> fetched; // 追加时不移动已有元素
+        auto add = [&](uint32_t id, std::vector<Stroke> const& strokes) {
+            if(strokes.empty()) return;
+            ids[id] = names.size();
+            names.push_back(_symbols->Name(id));
+            fetched.push_back(strokes), data.push_back(&fetched.back());
+        };
+        auto                         cache = std::atomic_load(&_dbSearchCache);
+        auto                         batch = BatchSearch();
+        std::unordered_set<uint32_t> queued;
+        std::vector<uint32_t>        level;
+        for(size_t scanned = 0;;) {
+            for(; scanned < names.size(); scanned++)
+                for(auto& s: *data[scanned]) {
+                    if(s.type != STROKE_REFERENCE || ids.count(s.buhin) ||
+                        !queued.insert(s.buhin).second)
+                        continue;
+                    std::vector<Stroke> strokes;
+                    if(cache && cache->Peek(_symbols->Name(s.buhin), strokes))
+                        add(s.buhin, strokes);
+                    else
+                        level.push_back(s.buhin);
+                }
+            if(level.empty() || !batch) break;
+            std::vector<std::string> query;
+            for(auto i: level)
+                query.push_back(_symbols->Name(i));
+            auto result = batch(query);
+            // 批量查询返回的结果不足时，缺少的部分视为缺失且不缓存
+            for(size_t i = 0; i < level.size() && i < result.size(); i++) {
+                auto strokes = StrokesParse(result[i], *_symbols);
+                if(cache) cache->Put(query[i], strokes);
+                add(level[i], strokes);
+            }
+            level.clear();
+        }
+
+        size_t                           n = names.size();
+        std::vector<std::vector<size_t>> children(n);
+        std::vector<CheckGlyphState>     direct(n, CHECK_OK);
+        for(size_t i = 0; i < n; i++)
+            for(auto& s: *data[i]) {
+                if(s.type != STROKE_REFERENCE) continue;
+                auto it = ids.find(s.buhin);
+                if(it != ids.end())
+                    children[i].push_back(it->second);
+                else {
+                    report.missing.push_back(
+                        {names[i], _symbols->Name(s.buhin)});
+                    direct[i] = CHECK_BUHIN_NOTFOUND;
+                }
+            }
+
+        if(threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = std::max((size_t)1, std::min(threads, n));
+        std::vector<std::atomic<uint8_t>> memo(n);
+        std::atomic<size_t>               next(0);
+        std::vector<std::thread>          workers;
+        for(size_t t = 0; t < threads; t++)
+            workers.emplace_back([&]() {
+                std::vector<uint8_t> onStack(n, 0);
+                for(size_t i; (i = next++) < n;)
+                    CheckFrom(children, direct, i, memo, onStack);
+            });
+        for(auto& i: workers)
+            i.join();
+
+        std::vector<CheckGlyphState> states(n);
+        for(size_t i = 0; i < n; i++) {
+            states[i]               = (CheckGlyphState)(memo[i].load() - 1);
+            report.states[names[i]] = states[i];
+        }
+        std::vector<std::vector<size_t>> cycles;
+        CheckCycles(children, states, cycles);
+        for(auto& i: cycles) {
+            std::vector<std::string> path;
+            for(auto j: i)
+                path.push_back(names[j]);
+            report.cycles.push_back(path);
+        }
+        std::sort(report.missing.begin(), report.missing.end());
+        std::sort(report.cycles.begin(), report.cycles.end());
+        return report;
+    }
+
+    uint64_t Kage::GetGlyphHash(std::string buhin) {
+        auto db        = _kageDB.Snapshot();
+        auto glyphData = SearchBuhin(db, buhin);
+        if(glyphData.empty()) glyphData = _notDefGlyph;
+        return GetGlyphHash2(db, glyphData);
+    }
+
+    // 与MakeGlyph2使用的缓存键相同
+    uint64_t Kage::GetGlyphHash2(std::vector<Stroke> data) {
+        return GetGlyphHash2(_kageDB.Snapshot(), data);
+    }
+
+    uint64_t Kage::GetGlyphHash2(
+        BuhinSnapshot const& db, std::vector<Stroke> const& data) {
+        return GlyphHash(GetStrokes(db, data), _pkFont->GetType(),
+            _pkFont->GetSize(), *_symbols);
+    }
+
+    double Kage::EstimateCost(std::string buhin) {
+        auto db        = _kageDB.Snapshot();
+        auto glyphData = SearchBuhin(db, buhin);
+        if(glyphData.empty()) glyphData = _notDefGlyph;
+        std::unordered_map<uint32_t, std::pair<double, size_t>> memo;
+        auto cost = EstimateCost2(db, glyphData, memo);
+        return COST_GLYPH + cost.first + COST_DEPTH * cost.second;
+    }
+
+    double Kage::EstimateCost2(std::vector<Stroke> data) {
+        std::unordered_map<uint32_t, std::pair<double, size_t>> memo;
+        auto cost = EstimateCost2(_kageDB.Snapshot(), data, memo);
+        return COST_GLYPH + cost.first + COST_DEPTH * cost.second;
+    }
+
+    // 返回展开data的开销与引用的最大层数，同一部件只展开一次
+    // 展开前先在memo中记为空部件，循环引用因此不会无限递归
+    std::pair<double, size_t> Kage::EstimateCost2(BuhinSnapshot const& db,
+        std::vector<Stroke> const& data,
+        std::unordered_map<uint32_t, std::pair<double, size_t>>& memo) {
+        double cost  = 0;
+        size_t depth = 0;
+        for(auto& stroke: data) {
+            if(stroke.type != STROKE_REFERENCE) {
+                cost += EstimateStrokeCost(stroke);
+                continue;
+            }
+            std::pair<double, size_t> inner;
+            auto                      found = memo.find(stroke.buhin);
+            if(found != memo.end())
+                inner = found->second;
+            else {
+                memo[stroke.buhin] = {0, 0};
+                auto buhin         = SearchBuhinId(db, stroke.buhin);
+                inner = EstimateCost2(db, buhin.empty() ? _notDefGlyph : buhin,
+                    memo);
+                memo[stroke.buhin] = inner;
+            }
+            cost += COST_REFERENCE + inner.first;
+            depth = std::max(depth, inner.second + 1);
+        }
+        return {cost, depth};
+    }
+
     CheckGlyphState Kage::CheckGlyph2(std::vector<Stroke> data) {
-        for(auto stroke: data) {
+        return CheckGlyph2(_kageDB.Snapshot(), data);
+    }
+
+    CheckGlyphState Kage::CheckGlyph2(
+        BuhinSnapshot const& db, std::vector<Stroke> const& data) {
+        for(auto& stroke: data) {
             if(stroke.type == STROKE_REFERENCE) {
-                CheckGlyphState out = CheckGlyph(stroke.buhin);
+                CheckGlyphState out =
+                    CheckGlyph(db, _symbols->Name(stroke.buhin));
                 if(out != CHECK_OK) return out;
             }
         }
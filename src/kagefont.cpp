@@ -1,13 +1,182 @@
+#include <cstring>
+
 #include "kagefont.h"
+#include "stats.h"
+#include "trace.h"
 
 namespace Kage {
 
     KageFont::KageFont(double size) {
         _size = size;
+        SetMemoCapacity(_strokeMemo, STROKE_MEMO_CAPACITY);
+        SetMemoCapacity(_instanceMemo, INSTANCE_MEMO_CAPACITY);
+    }
+
+    // 绘制用到的笔画字段，坐标按位保存
+    std::string KageFont::StrokeMemoKey(Stroke const& s) {
+        std::string key;
+        for(auto i: {(signed)s.type, (signed)s.start, (signed)s.end, s.typeOpt,
+                s.startOpt, s.endOpt})
+            key.append((const char*)&i, sizeof(i));
+        for(auto i: {s.p1, s.p2, s.p3, s.p4})
+            StrokeMemoKeyAppend(key, i.x), StrokeMemoKeyAppend(key, i.y);
+        return key;
+    }
+
+    void KageFont::StrokeMemoKeyAppend(std::string& key, double v) {
+        char bytes[sizeof(v)];
+        std::memcpy(bytes, &v, sizeof(v));
+        key.append(bytes, sizeof(v));
+    }
+
+    // 命中时直接推入已有的轮廓，未命中时在临时画布上绘制后存入
+    void KageFont::DrawMemoized(Canva& cv, OutlineMemo& memo,
+        std::string const& key, std::function<void(Canva&)> const& draw) {
+        auto& shard = memo.shards[std::hash<std::string>()(key) % MEMO_SHARDS];
+        std::vector<Contour>         contours;
+        std::unique_lock<std::mutex> lock(shard.mutex, std::defer_lock);
+        TraceLock(lock, "MemoLockWait");
+        if(shard.entries.Capacity() == 0) {
+            lock.unlock();
+            draw(cv);
+            return;
+        }
+        auto cached = shard.entries.Get(key);
+        if(cached) {
+            shard.hits++;
+            contours = *cached;
+            lock.unlock();
+        } else {
+            shard.misses++;
+            lock.unlock();
+            Canva temp;
+            draw(temp);
+            contours    = temp.Contours();
+            size_t cost = 1;
+            for(auto& i: contours) cost += i.Size();
+            TraceLock(lock, "MemoLockWait");
+            shard.entries.Put(key, contours, cost);
+            lock.unlock();
+        }
+        for(auto& i: contours) cv.Push(i);
+    }
+
+    // 不受部件外笔画影响的部件按其笔画整体记忆，其余笔画逐个绘制
+    // 翻转、旋转作用于此前的整个画布，含有它们的部件不单独绘制
+    void KageFont::DrawStrokes(Canva& cv, std::vector<Stroke> const& strokes,
+        std::vector<StrokeGroup> const& groups) {
+#ifdef KAGE_ENABLE_STATS
+        for(auto& i: strokes) KAGE_STATS_STROKE(i);
+#endif
+        auto group = groups.begin();
+        for(size_t i = 0; i < strokes.size();) {
+            while(group != groups.end() && group->begin < i) group++;
+            if(group == groups.end() || group->begin != i ||
+                group->end <= i || group->end > strokes.size()) {
+                DrawStrokeInGlyph(cv, strokes, i++);
+                continue;
+            }
+            const size_t begin = i, end = group->end;
+            bool         special = false;
+            for(size_t j = begin; j < end; j++)
+                if(strokes[j].type == STROKE_SPECIAL) special = true;
+            if(special || !IsIsolated(strokes, begin, end)) {
+                DrawStrokeInGlyph(cv, strokes, i++);
+                continue;
+            }
+            KAGE_TRACE_SCOPE("DrawComponent");
+            std::string key;
+            for(size_t j = begin; j < end; j++)
+                key += StrokeMemoKey(strokes[j]);
+            DrawMemoized(cv, _instanceMemo, key, [&](Canva& c) {
+                std::vector<Stroke> part(
+                    strokes.begin() + begin, strokes.begin() + end);
+                for(size_t j = 0; j < part.size(); j++)
+                    DrawStrokeInGlyph(c, part, j);
+            });
+            i = end;
+        }
+    }
+
+    Canva KageFont::DrawGlyph(
+        std::vector<Stroke> strokes, std::vector<StrokeGroup> const& groups) {
+        Canva cv;
+        DrawStrokes(cv, strokes, groups);
+        return cv;
+    }
+
+    // 每个轮廓画好后立即输出；含翻转、旋转的字形须先完整绘制再输出
+    void KageFont::DrawGlyph(std::vector<Stroke> strokes, PathSink& sink,
+        std::vector<StrokeGroup> const& groups) {
+        for(auto& i: strokes) {
+            if(i.type == STROKE_SPECIAL &&
+                (i.spe1 == SPECIAL1_FLIP_UPDOWN ||
+                    i.spe1 == SPECIAL1_FLIP_LEFTRIGHT ||
+                    i.spe1 == SPECIAL1_ROTATE)) {
+                DrawGlyph(strokes, groups).Replay(sink);
+                return;
+            }
+        }
+        Canva cv(sink);
+        DrawStrokes(cv, strokes, groups);
     }
 
     KageFontType KageFont::GetType() {
         return _type;
     }
 
+    double KageFont::GetSize() {
+        return _size;
+    }
+
+    // 各份平分容量（向上取整）
+    void KageFont::SetMemoCapacity(OutlineMemo& memo, size_t capacity) {
+        for(auto& i: memo.shards) {
+            std::lock_guard<std::mutex> lock(i.mutex);
+            i.entries.SetCapacity((capacity + MEMO_SHARDS - 1) / MEMO_SHARDS);
+        }
+    }
+
+    size_t KageFont::MemoHits(OutlineMemo& memo) {
+        size_t hits = 0;
+        for(auto& i: memo.shards) {
+            std::lock_guard<std::mutex> lock(i.mutex);
+            hits += i.hits;
+        }
+        return hits;
+    }
+
+    size_t KageFont::MemoMisses(OutlineMemo& memo) {
+        size_t misses = 0;
+        for(auto& i: memo.shards) {
+            std::lock_guard<std::mutex> lock(i.mutex);
+            misses += i.misses;
+        }
+        return misses;
+    }
+
+    void KageFont::SetStrokeMemoCapacity(size_t capacity) {
+        SetMemoCapacity(_strokeMemo, capacity);
+    }
+
+    size_t KageFont::StrokeMemoHits() {
+        return MemoHits(_strokeMemo);
+    }
+
+    size_t KageFont::StrokeMemoMisses() {
+        return MemoMisses(_strokeMemo);
+    }
+
+    void KageFont::SetInstanceMemoCapacity(size_t capacity) {
+        SetMemoCapacity(_instanceMemo, capacity);
+    }
+
+    size_t KageFont::InstanceMemoHits() {
+        return MemoHits(_instanceMemo);
+    }
+
+    size_t KageFont::InstanceMemoMisses() {
+        return MemoMisses(_instanceMemo);
+    }
+
 } // namespace Kage
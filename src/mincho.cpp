@@ -2,6 +2,8 @@
 
 #include "bezier.h"
 #include "mincho.h"
+#include "stats.h"
+#include "trace.h"
 
 namespace Kage {
 
@@ -9,7 +11,7 @@ namespace Kage {
     const auto BEZ_CIR    = 4 * (std::sqrt(2) - 1) / 3;
 
     // mincho.js/Mincho/constructor
-    Mincho::Mincho(double size) {
+    Mincho::Mincho(double size): KageFont(size) {
         _type = KAGEFONT_MINCHO;
         if(size == 1) {
             kMinWidthY = 1.2, kMinWidthU = 1.2, kMinWidthT = 3.6, kWidth = 3,
@@ -513,7 +515,8 @@ namespace Kage {
     }
 
     // mincho.js/Mincho/adjustUrokoParam
-    double Mincho::AdjustUrokoParam(Stroke stroke, std::vector<Stroke> others) {
+    double Mincho::AdjustUrokoParam(
+        Stroke stroke, std::vector<Stroke> const& others) {
         // for illegal strokes
         if(stroke.endOpt != 0) return stroke.endOpt % 10;
         if(stroke.typeOpt != 0) return 0;
@@ -541,7 +544,7 @@ namespace Kage {
 
     // mincho.js/Mincho/adjustUroko2Param
     double Mincho::AdjustUroko2Param(
-        Stroke stroke, std::vector<Stroke> others) {
+        Stroke stroke, std::vector<Stroke> const& others) {
         // for illegal strokes
         if(stroke.endOpt != 0) return stroke.endOpt % 10;
         if(stroke.typeOpt != 0) return 0;
@@ -571,7 +574,8 @@ namespace Kage {
     }
 
     // mincho.js/Mincho/adjustTateParam
-    double Mincho::AdjustTateParam(Stroke stroke, std::vector<Stroke> others) {
+    double Mincho::AdjustTateParam(
+        Stroke stroke, std::vector<Stroke> const& others) {
         // for illegal strokes
         if(stroke.startOpt >= 10) return (stroke.startOpt % 100) / 10;
         if(stroke.typeOpt != 0) return 0;
@@ -601,7 +605,7 @@ namespace Kage {
     // mincho.js/Mincho/adjustHaneParam
     // adjust "Hane" (short line turning to the left)
     double Mincho::AdjustHaneParam(
-        Stroke stroke, Point ep, std::vector<Stroke> others) {
+        Stroke stroke, Point ep, std::vector<Stroke> const& others) {
         // for illegal strokes
         if(stroke.endOpt != 0) return stroke.endOpt % 10;
         if(stroke.typeOpt != 0) return 0;
@@ -625,7 +629,7 @@ namespace Kage {
 
     // mincho.js/Mincho/adjustKakatoParam
     double Mincho::AdjustKakatoParam(
-        Stroke stroke, std::vector<Stroke> others) {
+        Stroke stroke, std::vector<Stroke> const& others) {
         // for illegal strokes
         if(stroke.endOpt != 0) return stroke.endOpt % 10;
         if(stroke.typeOpt != 0) return 0;
@@ -649,7 +653,7 @@ namespace Kage {
     // mincho.js/Mincho/adjustKakatoParam
     // connecting to other strokes.
     bool Mincho::AdjustKirikuchiParam(
-        Stroke stroke, std::vector<Stroke> others) {
+        Stroke stroke, std::vector<Stroke> const& others) {
         // for illegal strokes
         if(stroke.startOpt % 10 == 1) return true;
         if(stroke.typeOpt != 0) return false;
@@ -667,7 +671,8 @@ namespace Kage {
     }
 
     // mincho.js/Mincho/adjustMageParam
-    double Mincho::AdjustMageParam(Stroke stroke, std::vector<Stroke> others) {
+    double Mincho::AdjustMageParam(
+        Stroke stroke, std::vector<Stroke> const& others) {
         // for illegal strokes
         if(stroke.startOpt % 10 != 0) return (stroke.startOpt % 100) / 10;
         if(stroke.typeOpt != 0) return 0;
@@ -1121,16 +1126,55 @@ namespace Kage {
         return {tan1, tan2};
     }
 
-    // mincho.js/Mincho/drawAdjustedStroke
-    void Mincho::DrawAdjustedStroke(
-        Canva& cv, Stroke s, std::vector<Stroke> others) {
-        const Dir dir12    = (s.p2 - s.p1).GetDir(),
-                  dir23    = (s.p3 - s.p2).GetDir(),
-                  dir34    = (s.p4 - s.p3).GetDir();
-        const double rad12 = (s.p2 - s.p1).GetRad(),
-                     rad23 = (s.p3 - s.p2).GetRad();
+    // 计算s绘制时用到的、由其他笔画决定的调整值，条件与DrawStroke中一致
+    MinchoAdjustment Mincho::GetAdjustment(
+        Stroke s, std::vector<Stroke> const& others) {
+        KAGE_STATS_SCOPE(STATS_ADJUST);
+        MinchoAdjustment adj = {0, 0, 0, 0, 0, 0, false};
         switch(s.type) {
-        case STROKE_SPECIAL: {
+        case STROKE_STRAIGHT:
+            if(s.end == END_CONNECTING_H) break;
+            if(s.end == END_OPEN &&
+                std::abs(s.p2.y - s.p1.y) < s.p2.x - s.p1.x) {
+                adj.uroko  = AdjustUrokoParam(s, others);
+                adj.uroko2 = AdjustUroko2Param(s, others);
+                break;
+            }
+            adj.tate = AdjustTateParam(s, others);
+            if(s.end == END_TURN_LEFT)
+                adj.hane = AdjustHaneParam(s, s.p2, others);
+            else if(s.end == END_LOWER_LEFT_CORNER ||
+                s.end == END_LOWER_RIGHT_CORNER)
+                adj.kakato = AdjustKakatoParam(s, others);
+            break;
+        case STROKE_CURVE:
+            if(s.start == START_CONNECTING_MANUAL) {
+                s.type = STROKE_STRAIGHT;
+                return GetAdjustment(s, others);
+            }
+            adj.kirikuchi = s.start == START_CONNECTING_V &&
+                AdjustKirikuchiParam(s, others);
+            if(s.end == END_TURN_LEFT)
+                adj.hane = AdjustHaneParam(s, s.p3, others);
+            break;
+        case STROKE_BENDING:
+            adj.tate = AdjustTateParam(s, others);
+            adj.mage = AdjustMageParam(s, others);
+            break;
+        case STROKE_BEZIER:
+            if(s.end == END_TURN_LEFT)
+                adj.hane = AdjustHaneParam(s, s.p4, others);
+            break;
+        case STROKE_VCURVE: adj.tate = AdjustTateParam(s, others); break;
+        default: break;
+        }
+        return adj;
+    }
+
+    // 轮廓只取决于笔画本身、调整值与字体参数，故可按前两者记忆化
+    void Mincho::DrawAdjustedStroke(
+        Canva& cv, Stroke s, std::vector<Stroke> const& others) {
+        if(s.type == STROKE_SPECIAL) {
             if(s.spe1 == SPECIAL1_FLIP_LEFTRIGHT)
                 cv.FlipLR(s.p1, s.p2);
             else if(s.spe1 == SPECIAL1_FLIP_UPDOWN)
@@ -1141,8 +1185,25 @@ namespace Kage {
                 cv.Rotate180(s.p1, s.p2);
             else if(s.spe1 == SPECIAL1_ROTATE && s.spe2 == SPECIAL2_ROTATE_270)
                 cv.Rotate270(s.p1, s.p2);
-            break;
+            return;
         }
+        const auto adj = GetAdjustment(s, others);
+        auto       key = StrokeMemoKey(s);
+        for(auto i: {adj.uroko, adj.uroko2, adj.tate, adj.hane, adj.kakato,
+                adj.mage, adj.kirikuchi ? 1.0 : 0.0})
+            StrokeMemoKeyAppend(key, i);
+        DrawMemoized(
+            cv, _strokeMemo, key, [&](Canva& c) { DrawStroke(c, s, adj); });
+    }
+
+    // mincho.js/Mincho/drawAdjustedStroke
+    void Mincho::DrawStroke(Canva& cv, Stroke s, MinchoAdjustment const& adj) {
+        const Dir dir12    = (s.p2 - s.p1).GetDir(),
+                  dir23    = (s.p3 - s.p2).GetDir(),
+                  dir34    = (s.p4 - s.p3).GetDir();
+        const double rad12 = (s.p2 - s.p1).GetRad(),
+                     rad23 = (s.p3 - s.p2).GetRad();
+        switch(s.type) {
         case STROKE_STRAIGHT: {
             const Dir dir = dir12;
             if(s.end == END_CONNECTING_H) // usually horizontal
@@ -1152,8 +1213,7 @@ namespace Kage {
                 // 绘制横线
                 cv.DrawLine(s.p1, s.p2, kMinWidthYY);
                 // 计算横末端三角的参数
-                const auto param_uroko  = AdjustUrokoParam(s, others),
-                           param_uroko2 = AdjustUroko2Param(s, others);
+                const auto param_uroko = adj.uroko, param_uroko2 = adj.uroko2;
                 const double urokoScale =
                     (kMinWidthU / kMinWidthY - 1.0) / 4.0 + 1.0;
                 if(s.p1.y == s.p2.y) { // horizontal
@@ -1172,7 +1232,7 @@ namespace Kage {
                         kAdjustUrokoY[param_uroko] * urokoScale);
             } else { // 竖笔
                 Contour    poly_end(2);
-                const auto param_tate    = AdjustTateParam(s, others);
+                const auto param_tate    = adj.tate;
                 const auto kMinWidthT_m  = kMinWidthT - param_tate / 2;
                 bool       connectVerror = false;  // Modified(2025/8/28),为表现与原版kage一致
                 // 头部
@@ -1206,7 +1266,7 @@ namespace Kage {
                     auto newp2 = Point(new_x2, s.p2.y);
                     cv.DrawQBezier(t1, s.p2, newp2, width_func,
                         [](double t) -> double { return 0; }, 0, true, false);
-                    const auto param_hane = AdjustHaneParam(s, s.p2, others);
+                    const auto param_hane = adj.hane;
                     DrawTurnLeft(cv, newp2, kMinWidthT_m,
                         kWidth * 4 *
                             std::min(1 - param_hane / 10,
@@ -1215,7 +1275,7 @@ namespace Kage {
                     break;
                 }
                 case END_LOWER_LEFT_CORNER: {
-                    const auto param_kakato = AdjustKakatoParam(s, others);
+                    const auto param_kakato = adj.kakato;
                     const auto right2       = kAdjustKakatoL[param_kakato] +
                         kMinWidthC * kMinWidthT_m,
                                left2 = kAdjustKakatoL[param_kakato];
@@ -1224,7 +1284,7 @@ namespace Kage {
                     break;
                 }
                 case END_LOWER_RIGHT_CORNER: {
-                    const auto param_kakato = AdjustKakatoParam(s, others);
+                    const auto param_kakato = adj.kakato;
                     const auto right2       = kAdjustKakatoR[param_kakato] +
                         kMinWidthC * kMinWidthT_m,
                                left2 = kAdjustKakatoR[param_kakato];
@@ -1328,8 +1388,7 @@ namespace Kage {
             // for CONNECTING_MANUAL stroke (very very tricky implementation)
             if(s.start == START_CONNECTING_MANUAL) {
                 s.type = STROKE_STRAIGHT; // CURVE -> STRAIGHT
-                DrawAdjustedStroke(
-                    cv, s, others); // treat as STRAIGHT line data
+                DrawStroke(cv, s, adj); // treat as STRAIGHT line data
                 return;
             }
             const auto kMinWidthT_mod =
@@ -1355,15 +1414,14 @@ namespace Kage {
                     cv, p1ext, dir12, kMinWidthT_mod); // this.kMinWidthC * ?
             }
             // 曲线部分
-            const auto a2temp = s.start == START_CONNECTING_V &&
-                AdjustKirikuchiParam(s, others);
+            const auto a2temp = adj.kirikuchi;
             DrawCurve(cv, s.p1, s.p2, s.p3, s.start, a2temp, s.end,
                 kMinWidthT_mod, end_width_factor);
             // 尾部
             switch(s.end) {
             case END_TURN_LEFT: {
                 auto       t1         = s.p3.MoveByDir(dir23, -kMage * 0.439);
-                const auto param_hane = AdjustHaneParam(s, s.p3, others);
+                const auto param_hane = adj.hane;
                 const auto width_func = [kMinWidthT_mod](double t) -> double {
                     return kMinWidthT_mod;
                 };
@@ -1395,10 +1453,7 @@ namespace Kage {
         }
         case STROKE_BENDING:
         case STROKE_BENDING_ROUND: {
-            const auto param_tate =
-                s.type == STROKE_BENDING ? AdjustTateParam(s, others) : 0;
-            const auto param_mage =
-                s.type == STROKE_BENDING ? AdjustMageParam(s, others) : 0;
+            const auto param_tate = adj.tate, param_mage = adj.mage;
             const auto kMinWidthT_m    = kMinWidthT - param_tate / 2;
             const auto kMinWidthT_mage = kMinWidthT - param_mage / 2;
             double     rate;
@@ -1498,7 +1553,7 @@ namespace Kage {
                 cv.DrawQBezier(pt1, s.p4, Point(s.p4.x - kMage, s.p4.y),
                     width_func, [](double t) -> double { return 0; }, 0, true,
                     false);
-                const auto param_hane = AdjustHaneParam(s, s.p4, others);
+                const auto param_hane = adj.hane;
                 DrawTurnLeft(cv, Point(s.p4.x - kMage, s.p4.y), kMinWidthT_mod,
                     kWidth * 4 *
                         std::min(1 - param_hane / 10,
@@ -1529,7 +1584,7 @@ namespace Kage {
             break;
         }
         case STROKE_VCURVE: {
-            const auto param_tate   = AdjustTateParam(s, others);
+            const auto param_tate   = adj.tate;
             const auto kMinWidthT_m = kMinWidthT - param_tate / 2;
             // straight
             auto poly_start =
@@ -1560,14 +1615,123 @@ namespace Kage {
     }
 
     // mincho.js/Mincho/getPolygons
-    Canva Mincho::DrawGlyph(std::vector<Stroke> strokes) {
-        Canva cv;
+    void Mincho::DrawStrokeInGlyph(
+        Canva& cv, std::vector<Stroke> const& strokes, size_t index) {
+        KAGE_TRACE_SCOPE_ARG(
+            "DrawStroke", std::to_string(strokes[index].type));
+        auto tempdata = strokes;
+        tempdata.erase(tempdata.begin() + index);
+        DrawAdjustedStroke(cv, strokes[index], tempdata);
+    }
+
+    // 调整判断中用到的点的包围盒，坐标无效时视为整个平面
+    // 不参与任何判断的笔画返回false
+    bool MinchoStrokeExtent(Stroke const& s, BoundingData& box) {
+        std::vector<Point> points;
+        switch((int)s.type) {
+        case STROKE_BEZIER:
+        case STROKE_VCURVE: points = {s.p1, s.p2, s.p3, s.p4}; break;
+        case STROKE_CURVE:
+        case 12:
+        case STROKE_BENDING:
+        case STROKE_BENDING_ROUND: points = {s.p1, s.p2, s.p3}; break;
+        case STROKE_STRAIGHT: points = {s.p1, s.p2}; break;
+        default: return false;
+        }
+        box = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+        for(auto i: points) {
+            if(std::isnan(i.x) || std::isnan(i.y)) {
+                box = {-INFINITY, -INFINITY, INFINITY, INFINITY};
+                break;
+            }
+            box.minX = std::min(box.minX, i.x);
+            box.maxX = std::max(box.maxX, i.x);
+            box.minY = std::min(box.minY, i.y);
+            box.maxY = std::max(box.maxY, i.y);
+        }
+        return true;
+    }
+
+    // 其他笔画落在这些范围之外时不会改变s的调整值，范围只大不小
+    // 条件与GetAdjustment一致
+    void Mincho::GetAdjustmentZones(Stroke s, std::vector<BoundingData>& zones) {
+        auto zone = [&](double x1, double y1, double x2, double y2) {
+            if(std::isnan(x1) || std::isnan(y1) || std::isnan(x2) ||
+                std::isnan(y2))
+                zones.push_back({-INFINITY, -INFINITY, INFINITY, INFINITY});
+            else // 留出1的余量，以免交点计算的误差
+                zones.push_back({std::min(x1, x2) - 1, std::min(y1, y2) - 1,
+                    std::max(x1, x2) + 1, std::max(y1, y2) + 1});
+        };
+        const double tate = kMinWidthT_adjust * kAdjustTateStep,
+                     mage = kMinWidthT_adjust * kAdjustMageStep;
+        double       uroko = 1;
+        for(auto i: kAdjustUrokoLine) uroko = std::max(uroko, i + 1);
+        switch(s.type) {
+        case STROKE_STRAIGHT:
+            if(s.end == END_CONNECTING_H) break;
+            if(s.end == END_OPEN &&
+                std::abs(s.p2.y - s.p1.y) < s.p2.x - s.p1.x) {
+                zone(s.p2.x - uroko, s.p2.y - uroko, s.p2.x + uroko,
+                    s.p2.y + uroko);
+                zone(s.p1.x, s.p1.y - kAdjustUroko2Length, s.p2.x,
+                    s.p1.y + kAdjustUroko2Length);
+                break;
+            }
+            zone(s.p1.x - tate, s.p1.y, s.p1.x + tate, s.p2.y);
+            if(s.end == END_TURN_LEFT)
+                zone(s.p2.x - 100, s.p2.y, s.p2.x, s.p2.y);
+            else if(s.end == END_LOWER_LEFT_CORNER ||
+                s.end == END_LOWER_RIGHT_CORNER)
+                zone(s.p2.x - kAdjustKakatoRangeX / 2,
+                    s.p2.y + kAdjustKakatoRangeY[0],
+                    s.p2.x + kAdjustKakatoRangeX / 2,
+                    s.p2.y + kAdjustKakatoRangeY[kAdjustKakatoStep]);
+            break;
+        case STROKE_CURVE:
+            if(s.start == START_CONNECTING_MANUAL) {
+                s.type = STROKE_STRAIGHT;
+                GetAdjustmentZones(s, zones);
+                break;
+            }
+            if(s.start == START_CONNECTING_V)
+                zone(s.p1.x, s.p1.y, s.p1.x, s.p1.y);
+            if(s.end == END_TURN_LEFT)
+                zone(s.p3.x - 100, s.p3.y, s.p3.x, s.p3.y);
+            break;
+        case STROKE_BENDING:
+            zone(s.p1.x - tate, s.p1.y, s.p1.x + tate, s.p2.y);
+            zone(s.p2.x, s.p2.y - mage, s.p3.x, s.p2.y + mage);
+            break;
+        case STROKE_BEZIER:
+            if(s.end == END_TURN_LEFT)
+                zone(s.p4.x - 100, s.p4.y, s.p4.x, s.p4.y);
+            break;
+        case STROKE_VCURVE:
+            zone(s.p1.x - tate, s.p1.y, s.p1.x + tate, s.p2.y);
+            break;
+        default: break;
+        }
+    }
+
+    // 部件内各笔画的调整范围内没有部件外的笔画时，部件可单独绘制
+    bool Mincho::IsIsolated(
+        std::vector<Stroke> const& strokes, size_t begin, size_t end) {
+        KAGE_STATS_SCOPE(STATS_ADJUST);
+        std::vector<BoundingData> zones;
+        for(size_t i = begin; i < end; i++)
+            GetAdjustmentZones(strokes[i], zones);
+        if(zones.empty()) return true;
         for(size_t i = 0; i < strokes.size(); i++) {
-            auto tempdata = strokes;
-            tempdata.erase(tempdata.begin() + i);
-            DrawAdjustedStroke(cv, strokes[i], tempdata);
+            BoundingData box;
+            if(i >= begin && i < end) continue;
+            if(!MinchoStrokeExtent(strokes[i], box)) continue;
+            for(auto& z: zones)
+                if(box.minX <= z.maxX && box.maxX >= z.minX &&
+                    box.minY <= z.maxY && box.maxY >= z.minY)
+                    return false;
         }
-        return cv;
+        return true;
     }
 
 } // namespace Kage
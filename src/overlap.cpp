@@ -0,0 +1,478 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+
+#include "overlap.h"
+
+namespace Kage {
+
+    // 原轮廓中的一段，直线段的两个控制点分别与两端点重合
+    typedef struct {
+        bool  isCubic;
+        Point p[4];
+    } OverlapSegment;
+
+    // 展开后的折线边，[t0, t1]为其在原曲线段seg上的参数区间
+    typedef struct {
+        Point  a, b;
+        size_t contour, seg;
+        double t0, t1;
+    } OverlapEdge;
+
+    typedef struct {
+        double t;
+        Point  p;
+    } OverlapSplit;
+
+    typedef std::pair<long long, long long> OverlapKey;
+
+    const double OVERLAP_PARAM_EPS   = 1e-9;
+    const double OVERLAP_SNAP_GRID   = 1e-6;
+    const double OVERLAP_TEST_OFFSET = 1e-5;
+    const size_t OVERLAP_MAX_PIECES  = 128;
+
+    double OverlapCross(Point a, Point b) {
+        return a.x * b.y - a.y * b.x;
+    }
+
+    OverlapKey OverlapSnap(Point p) {
+        return {std::llround(p.x / OVERLAP_SNAP_GRID),
+            std::llround(p.y / OVERLAP_SNAP_GRID)};
+    }
+
+    Point OverlapEval(OverlapSegment& s, double t) {
+        if(t <= 0) return s.p[0];
+        if(t >= 1) return s.p[3];
+        if(!s.isCubic) return s.p[0] + (s.p[3] - s.p[0]) * t;
+        double mt = 1 - t;
+        return s.p[0] * (mt * mt * mt) + s.p[1] * (3 * mt * mt * t) +
+            s.p[2] * (3 * mt * t * t) + s.p[3] * (t * t * t);
+    }
+
+    // 将轮廓拆分为直线段与三次曲线段（二次曲线升阶为三次）
+    void OverlapSegmentsOf(Contour&                     contour,
+                           std::vector<OverlapSegment>& segs) {
+        auto&  pts = contour.Points();
+        auto&  types = contour.PointTypes();
+        size_t n = pts.size(), start = n;
+        for(size_t i = 0; i < n; i++) {
+            if(types[i] == PT_POINT) {
+                start = i;
+                break;
+            }
+        }
+        if(start == n) return;
+        size_t i = start, walked = 0;
+        do {
+            OverlapSegment seg;
+            size_t         j = (i + 1) % n, step;
+            Point          p0 = pts[i];
+            if(types[j] == PT_POINT) {
+                seg.isCubic = false;
+                seg.p[0] = seg.p[1] = p0, seg.p[2] = seg.p[3] = pts[j];
+                step = 1;
+            } else if(types[j] == PT_CUBIC && types[(j + 1) % n] == PT_CUBIC) {
+                seg.isCubic = true;
+                seg.p[0] = p0, seg.p[1] = pts[j], seg.p[2] = pts[(j + 1) % n],
+                seg.p[3] = pts[(j + 2) % n];
+                step     = 3;
+            } else { // 二次曲线（或只有一个控制点的三次曲线）
+                Point c = pts[j], end = pts[(j + 1) % n];
+                seg.isCubic = true;
+                seg.p[0] = p0, seg.p[1] = p0 + (c - p0) * (2.0 / 3),
+                seg.p[2] = end + (c - end) * (2.0 / 3), seg.p[3] = end;
+                step     = 2;
+            }
+            segs.push_back(seg);
+            walked += step, i = (i + step) % n;
+        } while(walked < n);
+    }
+
+    // 用均匀参数展开曲线段，段数由二阶差分估计的误差上界决定
+    void OverlapFlatten(std::vector<OverlapSegment>& segs, size_t contour,
+        size_t segBase, double tolerance, std::vector<OverlapEdge>& edges) {
+        for(size_t k = 0; k < segs.size(); k++) {
+            auto&  s = segs[k];
+            size_t pieces = 1;
+            if(s.isCubic) {
+                double l = std::max(
+                    (s.p[0] - 2 * s.p[1] + s.p[2]).GetLength(),
+                    (s.p[1] - 2 * s.p[2] + s.p[3]).GetLength());
+                pieces   = std::ceil(std::sqrt(0.75 * l / tolerance));
+                pieces   = std::min(std::max(pieces, (size_t)1),
+                      OVERLAP_MAX_PIECES);
+            }
+            Point last = s.p[0];
+            for(size_t i = 1; i <= pieces; i++) {
+                double t0 = (double)(i - 1) / pieces, t1 = (double)i / pieces;
+                Point  p = OverlapEval(s, t1);
+                if(p != last)
+                    edges.push_back({last, p, contour, segBase + k, t0, t1});
+                last = p;
+            }
+        }
+    }
+
+    // 求两条边的交点（含端点接触与共线重叠），记录各自需要切分的位置
+    void OverlapIntersect(OverlapEdge& e1, OverlapEdge& e2,
+        std::vector<OverlapSplit>& s1, std::vector<OverlapSplit>& s2) {
+        Point r(e1.b.x - e1.a.x, e1.b.y - e1.a.y),
+            s(e2.b.x - e2.a.x, e2.b.y - e2.a.y),
+            q(e2.a.x - e1.a.x, e2.a.y - e1.a.y);
+        double denom = OverlapCross(r, s);
+        double lr = r.GetLength(), ls = s.GetLength();
+        if(std::abs(denom) > 1e-12 * lr * ls) {
+            double t = OverlapCross(q, s) / denom,
+                   u = OverlapCross(q, r) / denom;
+            if(t < -OVERLAP_PARAM_EPS || t > 1 + OVERLAP_PARAM_EPS ||
+                u < -OVERLAP_PARAM_EPS || u > 1 + OVERLAP_PARAM_EPS)
+                return;
+            bool tInner = t > OVERLAP_PARAM_EPS && t < 1 - OVERLAP_PARAM_EPS,
+                 uInner = u > OVERLAP_PARAM_EPS && u < 1 - OVERLAP_PARAM_EPS;
+            if(!tInner && !uInner) return;
+            // 交点落在某条边的端点上时直接使用该端点，保证顶点完全一致
+            Point p;
+            if(!tInner)
+                p = t < 0.5 ? e1.a : e1.b;
+            else if(!uInner)
+                p = u < 0.5 ? e2.a : e2.b;
+            else
+                p = e1.a + r * t;
+            if(tInner) s1.push_back({t, p});
+            if(uInner) s2.push_back({u, p});
+            return;
+        }
+        // 平行：仅处理共线重叠的情况
+        if(std::abs(OverlapCross(q, r)) > 1e-9 * lr) return;
+        double t = q.Dot(r) / (lr * lr);
+        if(t > OVERLAP_PARAM_EPS && t < 1 - OVERLAP_PARAM_EPS)
+            s1.push_back({t, e2.a});
+        t = (e2.b - e1.a).Dot(r) / (lr * lr);
+        if(t > OVERLAP_PARAM_EPS && t < 1 - OVERLAP_PARAM_EPS)
+            s1.push_back({t, e2.b});
+        t = (e1.a - e2.a).Dot(s) / (ls * ls);
+        if(t > OVERLAP_PARAM_EPS && t < 1 - OVERLAP_PARAM_EPS)
+            s2.push_back({t, e1.a});
+        t = (e1.b - e2.a).Dot(s) / (ls * ls);
+        if(t > OVERLAP_PARAM_EPS && t < 1 - OVERLAP_PARAM_EPS)
+            s2.push_back({t, e1.b});
+    }
+
+    // 按y方向分带存放边，加速绕数计算
+    typedef struct {
+        double                           minY, bandHeight;
+        std::vector<std::vector<size_t>> bands;
+    } OverlapBands;
+
+    OverlapBands OverlapMakeBands(std::vector<OverlapEdge>& edges) {
+        OverlapBands b;
+        double       minY = INFINITY, maxY = -INFINITY;
+        for(auto& e: edges) {
+            minY = std::min(minY, std::min(e.a.y, e.b.y));
+            maxY = std::max(maxY, std::max(e.a.y, e.b.y));
+        }
+        size_t count = std::min(std::max(edges.size() / 4, (size_t)1),
+            (size_t)256);
+        b.minY       = minY;
+        b.bandHeight = std::max((maxY - minY) / count, 1e-9);
+        b.bands.resize(count);
+        for(size_t i = 0; i < edges.size(); i++) {
+            auto&  e = edges[i];
+            double lo = std::min(e.a.y, e.b.y), hi = std::max(e.a.y, e.b.y);
+            size_t first = std::min((size_t)((lo - minY) / b.bandHeight),
+                       count - 1),
+                   last = std::min((size_t)((hi - minY) / b.bandHeight),
+                       count - 1);
+            for(size_t k = first; k <= last; k++)
+                b.bands[k].push_back(i);
+        }
+        return b;
+    }
+
+    // 判断点是否位于内部：绕数不为0的轮廓计入总和，填充的轮廓计1，洞计-1
+    // （orient），总和为正时在内部；填充的轮廓因此与其方向及自相交无关，
+    // 洞则从包含它的外轮廓中扣除
+    bool OverlapIsInside(std::vector<OverlapEdge>& edges, OverlapBands& b,
+        Point q, std::vector<int> const& orient, std::vector<int>& winding,
+        std::vector<size_t>& touched) {
+        if(q.y < b.minY) return false;
+        size_t band = (q.y - b.minY) / b.bandHeight;
+        if(band >= b.bands.size()) return false;
+        touched.clear();
+        for(auto i: b.bands[band]) {
+            auto&  e = edges[i];
+            int    delta = 0;
+            double side = (e.b.x - e.a.x) * (q.y - e.a.y) -
+                (q.x - e.a.x) * (e.b.y - e.a.y);
+            if(e.a.y <= q.y) {
+                if(e.b.y > q.y && side > 0) delta = 1;
+            } else if(e.b.y <= q.y && side < 0)
+                delta = -1;
+            if(delta == 0) continue;
+            if(winding[e.contour] == 0) touched.push_back(e.contour);
+            winding[e.contour] += delta;
+        }
+        int sum = 0;
+        for(auto c: touched) {
+            if(winding[c] != 0) sum += orient[c];
+            winding[c] = 0;
+        }
+        return sum > 0;
+    }
+
+    void OverlapSplitLeft(Point* p, double t, Point* out) {
+        Point p01 = p[0] + (p[1] - p[0]) * t, p12 = p[1] + (p[2] - p[1]) * t,
+              p23 = p[2] + (p[3] - p[2]) * t, p012 = p01 + (p12 - p01) * t,
+              p123 = p12 + (p23 - p12) * t;
+        out[0] = p[0], out[1] = p01, out[2] = p012,
+        out[3] = p012 + (p123 - p012) * t;
+    }
+
+    void OverlapSplitRight(Point* p, double t, Point* out) {
+        Point p01 = p[0] + (p[1] - p[0]) * t, p12 = p[1] + (p[2] - p[1]) * t,
+              p23 = p[2] + (p[3] - p[2]) * t, p012 = p01 + (p12 - p01) * t,
+              p123 = p12 + (p23 - p12) * t;
+        out[0] = p012 + (p123 - p012) * t, out[1] = p123, out[2] = p23,
+        out[3] = p[3];
+    }
+
+    // 截取三次曲线在[ta, tb]（ta < tb）上的部分
+    void OverlapSubCubic(OverlapSegment& s, double ta, double tb, Point* out) {
+        Point left[4];
+        OverlapSplitLeft(s.p, tb, left);
+        OverlapSplitRight(left, tb > 0 ? ta / tb : 0, out);
+    }
+
+    // 计算失败时返回输入的轮廓，只统一其方向
+    std::vector<Contour> OverlapFallback(std::vector<Contour>& contours) {
+        for(auto& c: contours)
+            c.NormalizeOrientation();
+        return contours;
+    }
+
+    std::vector<Contour> RemoveOverlap(
+        std::vector<Contour> contours, double tolerance) {
+        if(contours.size() == 0) return contours;
+        // 拆分并展开所有轮廓
+        std::vector<OverlapSegment> segs;
+        std::vector<OverlapEdge>    edges;
+        for(size_t c = 0; c < contours.size(); c++) {
+            std::vector<OverlapSegment> temp;
+            OverlapSegmentsOf(contours[c], temp);
+            OverlapFlatten(temp, c, segs.size(), tolerance, edges);
+            segs.insert(segs.end(), temp.begin(), temp.end());
+        }
+        if(edges.size() < 3) return OverlapFallback(contours);
+        for(auto& e: edges)
+            if(!e.a.isVaild() || !e.b.isVaild())
+                return OverlapFallback(contours);
+
+        // 扫描线求所有交点
+        std::vector<std::vector<OverlapSplit>> splits(edges.size());
+        std::vector<size_t>                    order(edges.size());
+        for(size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&edges](size_t l, size_t r) {
+            return std::min(edges[l].a.x, edges[l].b.x) <
+                std::min(edges[r].a.x, edges[r].b.x);
+        });
+        for(size_t i = 0; i < order.size(); i++) {
+            auto&  e1 = edges[order[i]];
+            double maxX = std::max(e1.a.x, e1.b.x),
+                   minY = std::min(e1.a.y, e1.b.y),
+                   maxY = std::max(e1.a.y, e1.b.y);
+            for(size_t j = i + 1; j < order.size(); j++) {
+                auto& e2 = edges[order[j]];
+                if(std::min(e2.a.x, e2.b.x) > maxX) break;
+                if(std::max(e2.a.y, e2.b.y) < minY ||
+                    std::min(e2.a.y, e2.b.y) > maxY)
+                    continue;
+                OverlapIntersect(
+                    e1, e2, splits[order[i]], splits[order[j]]);
+            }
+        }
+
+        // 在交点处切分，并将顶点吸附到网格上
+        std::vector<OverlapEdge>      pieces;
+        std::map<OverlapKey, Point>   vertices;
+        auto                          snap = [&vertices](Point p) -> Point {
+            return vertices.insert({OverlapSnap(p), p}).first->second;
+        };
+        for(size_t i = 0; i < edges.size(); i++) {
+            auto& e = edges[i];
+            auto& sp = splits[i];
+            std::sort(sp.begin(), sp.end(),
+                [](const OverlapSplit& l, const OverlapSplit& r) {
+                return l.t < r.t;
+            });
+            Point  last = snap(e.a);
+            double lastT = e.t0;
+            for(size_t k = 0; k <= sp.size(); k++) {
+                Point  p = k < sp.size() ? snap(sp[k].p) : snap(e.b);
+                double t = k < sp.size() ? e.t0 + (e.t1 - e.t0) * sp[k].t
+                                         : e.t1;
+                if(p == last) continue;
+                pieces.push_back({last, p, e.contour, e.seg, lastT, t});
+                last = p, lastT = t;
+            }
+        }
+
+        // 保留一侧在内部、另一侧在外部的边，并使内部位于边的左侧
+        // 内外状态只可能在与其他边相接的顶点处改变，因此同一轮廓上
+        // 相邻顶点度数均为2的一串边只需检测其中最长的一条
+        std::map<OverlapKey, size_t> degree;
+        for(auto& e: pieces)
+            degree[OverlapSnap(e.a)]++, degree[OverlapSnap(e.b)]++;
+        auto                bands = OverlapMakeBands(edges);
+        std::vector<int>    orient(contours.size());
+        for(size_t c = 0; c < contours.size(); c++)
+            orient[c] = contours[c].isHole() ? -1 : 1;
+        std::vector<int>    winding(contours.size(), 0);
+        std::vector<size_t> touched;
+        std::vector<int>    side(pieces.size(), 0); // 1:内部在左 -1:内部在右
+        for(size_t begin = 0, end; begin < pieces.size(); begin = end) {
+            end = begin;
+            while(end < pieces.size() &&
+                pieces[end].contour == pieces[begin].contour)
+                end++;
+            size_t n = end - begin, first = 0;
+            for(size_t k = 0; k < n; k++) {
+                if(degree[OverlapSnap(pieces[begin + k].a)] != 2) {
+                    first = k;
+                    break;
+                }
+            }
+            for(size_t k = 0; k < n;) {
+                size_t runBegin = k, longest = begin + (first + k) % n;
+                double longestLen = -1;
+                do {
+                    size_t i   = begin + (first + k) % n;
+                    double len = (pieces[i].b - pieces[i].a).GetLength();
+                    if(len > longestLen) longestLen = len, longest = i;
+                    k++;
+                } while(k < n && degree[OverlapSnap(
+                                     pieces[begin + (first + k) % n].a)] == 2);
+                auto& e = pieces[longest];
+                Point d = e.b - e.a;
+                Point m  = (e.a + e.b) / 2;
+                Point nv = Point(-d.y, d.x) * (OVERLAP_TEST_OFFSET / longestLen);
+                bool left  = OverlapIsInside(
+                    edges, bands, m + nv, orient, winding, touched);
+                bool right = OverlapIsInside(
+                    edges, bands, m - nv, orient, winding, touched);
+                int  s = left == right ? 0 : (left ? 1 : -1);
+                for(size_t j = runBegin; j < k; j++)
+                    side[begin + (first + j) % n] = s;
+            }
+        }
+        std::vector<OverlapEdge>                    kept;
+        std::set<std::pair<OverlapKey, OverlapKey>> keptKeys;
+        for(size_t i = 0; i < pieces.size(); i++) {
+            auto& e = pieces[i];
+            if(side[i] == 0) continue;
+            if(side[i] < 0) std::swap(e.a, e.b), std::swap(e.t0, e.t1);
+            if(keptKeys.insert({OverlapSnap(e.a), OverlapSnap(e.b)}).second)
+                kept.push_back(e);
+        }
+        if(kept.size() == 0) return OverlapFallback(contours);
+
+        // 连接边成环，分叉处选择向左转得最多的边
+        std::map<OverlapKey, std::vector<size_t>> outgoing;
+        for(size_t i = 0; i < kept.size(); i++)
+            outgoing[OverlapSnap(kept[i].a)].push_back(i);
+        std::vector<bool>                used(kept.size(), false);
+        std::vector<std::vector<size_t>> loops;
+        for(size_t i = 0; i < kept.size(); i++) {
+            if(used[i]) continue;
+            std::vector<size_t> loop;
+            auto                startKey = OverlapSnap(kept[i].a);
+            size_t              cur = i;
+            while(true) {
+                used[cur] = true;
+                loop.push_back(cur);
+                auto endKey = OverlapSnap(kept[cur].b);
+                if(endKey == startKey) break;
+                auto&  cand = outgoing[endKey];
+                Point  dir = kept[cur].b - kept[cur].a;
+                size_t next = kept.size();
+                double best = -INFINITY;
+                for(auto c: cand) {
+                    if(used[c]) continue;
+                    Point  out = kept[c].b - kept[c].a;
+                    double turn = std::atan2(
+                        OverlapCross(dir, out), dir.Dot(out));
+                    if(turn > best) best = turn, next = c;
+                }
+                if(next == kept.size()) // 无法闭合
+                    return OverlapFallback(contours);
+                cur = next;
+            }
+            loops.push_back(loop);
+        }
+
+        // 填充的轮廓面积为正，洞为负（所有环的面积之和为正）
+        std::vector<double> loopAreas;
+        double              outputArea = 0;
+        for(auto& loop: loops) {
+            double area = 0;
+            for(auto i: loop)
+                area += OverlapCross(kept[i].a, kept[i].b) / 2;
+            loopAreas.push_back(area), outputArea += area;
+        }
+        bool reverse = outputArea < 0;
+
+        // 同一原曲线段上参数连续的边合并，恢复为直线或截取的三次曲线
+        std::vector<Contour> result;
+        for(size_t l = 0; l < loops.size(); l++) {
+            auto& loop = loops[l];
+            auto continued = [&kept](size_t prev, size_t next) -> bool {
+                return kept[prev].seg == kept[next].seg &&
+                    kept[prev].t1 == kept[next].t0;
+            };
+            size_t n = loop.size(), start = 0;
+            for(size_t k = 0; k < n; k++) {
+                if(!continued(loop[(k + n - 1) % n], loop[k])) {
+                    start = k;
+                    break;
+                }
+            }
+            Contour contour;
+            contour.MoveTo(kept[loop[start]].a);
+            for(size_t k = 0; k < n;) {
+                size_t first = loop[(start + k) % n], last = first;
+                k++;
+                while(k < n && continued(last, loop[(start + k) % n]))
+                    last = loop[(start + k) % n], k++;
+                auto&  seg = segs[kept[first].seg];
+                double ta = kept[first].t0, tb = kept[last].t1;
+                if(!seg.isCubic || std::abs(tb - ta) < OVERLAP_PARAM_EPS) {
+                    contour.LineTo(kept[last].b);
+                    continue;
+                }
+                Point sub[4];
+                if(ta < tb)
+                    OverlapSubCubic(seg, ta, tb, sub);
+                else {
+                    OverlapSubCubic(seg, tb, ta, sub);
+                    std::swap(sub[1], sub[2]);
+                }
+                contour.CubicTo(sub[1], sub[2], kept[last].b);
+            }
+            // 末尾回到起点的直线由闭合隐含
+            auto& pts = contour.Points();
+            if(pts.size() > 1 && pts.back() == pts.front() &&
+                contour.PointTypes()[pts.size() - 2] == PT_POINT) {
+                contour.PointTypes().pop_back();
+                pts.pop_back();
+            }
+            if(reverse) contour.Reverse();
+            contour.SetHole((loopAreas[l] < 0) != reverse);
+            result.push_back(contour);
+        }
+        return result;
+    }
+
+} // namespace Kage
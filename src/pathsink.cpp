@@ -0,0 +1,48 @@
+#include "pathsink.h"
+
+#include "canva.h"
+
+namespace Kage {
+
+    CanvaSink::CanvaSink(Canva& canva): _canva(canva) {}
+
+    void CanvaSink::MoveTo(Point p) {
+        _contour = Contour();
+        _contour.MoveTo(p);
+    }
+
+    void CanvaSink::LineTo(Point p) {
+        _contour.LineTo(p);
+    }
+
+    void CanvaSink::QuadTo(Point p1, Point p2) {
+        _contour.QuadraticTo(p1, p2);
+    }
+
+    void CanvaSink::CubicTo(Point p1, Point p2, Point p3) {
+        _contour.CubicTo(p1, p2, p3);
+    }
+
+    void CanvaSink::Close() {
+        _canva.Push(_contour);
+        _contour = Contour();
+    }
+
+    // 按点的种类还原为绘制命令，空轮廓不输出
+    void Contour2Sink(Contour& contour, PathSink& sink) {
+        auto& pts   = contour.Points();
+        auto& types = contour.PointTypes();
+        if(pts.empty()) return;
+        sink.MoveTo(pts[0]);
+        for(size_t j = 1; j < pts.size();) {
+            if(types[j] == PT_QUAD && j + 1 < pts.size())
+                sink.QuadTo(pts[j], pts[j + 1]), j += 2;
+            else if(types[j] == PT_CUBIC && j + 2 < pts.size())
+                sink.CubicTo(pts[j], pts[j + 1], pts[j + 2]), j += 3;
+            else
+                sink.LineTo(pts[j]), j++;
+        }
+        sink.Close();
+    }
+
+} // namespace Kage
@@ -0,0 +1,117 @@
+#include "raster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace Kage {
+
+    // 按像素长度决定曲线展开的段数
+    size_t RasterSegments(double length) {
+        return std::max((size_t)1,
+            std::min((size_t)64, (size_t)std::ceil(std::sqrt(length) * 2)));
+    }
+
+    RasterSink::RasterSink(size_t width, size_t height, double scale) {
+        _width = width, _height = height, _scale = scale;
+    }
+
+    void RasterSink::Edge(Point p) {
+        Point a = _last * _scale, b = p * _scale;
+        if(a.y != b.y)
+            _edges.push_back({a.x, a.y, b.x, b.y, b.y > a.y ? 1 : -1});
+        _last = p;
+    }
+
+    void RasterSink::MoveTo(Point p) {
+        _start = _last = p;
+    }
+
+    void RasterSink::LineTo(Point p) {
+        Edge(p);
+    }
+
+    void RasterSink::QuadTo(Point p1, Point p2) {
+        Point  p0 = _last;
+        size_t n  = RasterSegments(
+            ((p1 - p0).GetLength() + (p2 - p1).GetLength()) * _scale);
+        for(size_t i = 1; i <= n; i++) {
+            double t = (double)i / n, s = 1 - t;
+            Edge(p0 * (s * s) + p1 * (2 * s * t) + p2 * (t * t));
+        }
+    }
+
+    void RasterSink::CubicTo(Point p1, Point p2, Point p3) {
+        Point  p0 = _last;
+        size_t n  = RasterSegments(((p1 - p0).GetLength() +
+                                       (p2 - p1).GetLength() +
+                                       (p3 - p2).GetLength()) *
+            _scale);
+        for(size_t i = 1; i <= n; i++) {
+            double t = (double)i / n, s = 1 - t;
+            Edge(p0 * (s * s * s) + p1 * (3 * s * s * t) +
+                p2 * (3 * s * t * t) + p3 * (t * t * t));
+        }
+    }
+
+    void RasterSink::Close() {
+        Edge(_start);
+    }
+
+    void RasterSink::Clear() {
+        _edges.clear();
+    }
+
+    // 每条采样线上按x排序交点，累计绕数不为0的区间，区间两端按覆盖比例计入
+    std::vector<uint8_t> RasterSink::Pixels() {
+        std::vector<float>  coverage(_width * _height, 0);
+        std::vector<size_t> order(_edges.size());
+        for(size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        auto top = [this](size_t i) {
+            return std::min(_edges[i].y0, _edges[i].y1);
+        };
+        std::sort(order.begin(), order.end(),
+            [&](size_t a, size_t b) { return top(a) < top(b); });
+        std::vector<size_t>                 active;
+        std::vector<std::pair<double, int>> crossings;
+        size_t                              next   = 0;
+        const float                         weight = 1.0f / RASTER_SUBSAMPLES;
+        for(size_t y = 0; y < _height; y++) {
+            float* row = &coverage[y * _width];
+            for(int k = 0; k < RASTER_SUBSAMPLES; k++) {
+                double sy = y + (k + 0.5) / RASTER_SUBSAMPLES;
+                while(next < order.size() && top(order[next]) <= sy)
+                    active.push_back(order[next++]);
+                crossings.clear();
+                for(size_t i = 0; i < active.size();) {
+                    auto& e = _edges[active[i]];
+                    if(std::max(e.y0, e.y1) <= sy) {
+                        active[i] = active.back(), active.pop_back();
+                        continue;
+                    }
+                    crossings.push_back(
+                        {e.x0 + (sy - e.y0) * (e.x1 - e.x0) / (e.y1 - e.y0),
+                            e.winding});
+                    i++;
+                }
+                std::sort(crossings.begin(), crossings.end());
+                int winding = 0;
+                for(size_t i = 0; i + 1 < crossings.size(); i++) {
+                    winding += crossings[i].second;
+                    if(winding == 0) continue;
+                    double x0 = std::max(0.0, crossings[i].first),
+                           x1 = std::min((double)_width, crossings[i + 1].first);
+                    for(double x = std::floor(x0); x < x1; x++)
+                        row[(size_t)x] += weight *
+                            (float)(std::min(x1, x + 1) - std::max(x0, x));
+                }
+            }
+        }
+        std::vector<uint8_t> pixels(coverage.size());
+        for(size_t i = 0; i < coverage.size(); i++)
+            pixels[i] = (uint8_t)std::lround(std::min(1.0f, coverage[i]) * 255);
+        return pixels;
+    }
+
+} // namespace Kage
@@ -0,0 +1,48 @@
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+#include "schedule.h"
+
+namespace Kage {
+
+    double EstimateStrokeCost(Stroke const& stroke) {
+        double cost = stroke.type < 8 ? COST_STROKE[stroke.type] : 0;
+        if(stroke.type != STROKE_SPECIAL &&
+            (stroke.end == END_TURN_LEFT || stroke.end == END_TURN_UPWARDS))
+            cost += COST_HOOK;
+        return cost;
+    }
+
+    std::vector<size_t> ScheduleLongestFirst(
+        std::vector<double> const& costs, size_t block) {
+        std::vector<size_t> order(costs.size());
+        for(size_t i = 0; i < order.size(); i++) order[i] = i;
+        if(block == 0) block = std::max((size_t)1, costs.size());
+        for(size_t begin = 0; begin < order.size(); begin += block) {
+            auto end = order.begin() + std::min(order.size(), begin + block);
+            std::stable_sort(order.begin() + begin, end,
+                [&](size_t a, size_t b) { return costs[a] > costs[b]; });
+        }
+        return order;
+    }
+
+    std::vector<size_t> PartitionByCost(
+        std::vector<double> const& costs, size_t parts) {
+        std::vector<size_t> part(costs.size());
+        parts = std::max((size_t)1, parts);
+        // 总开销最小的份，相同时取编号最小的
+        typedef std::pair<double, size_t> Load;
+        std::priority_queue<Load, std::vector<Load>, std::greater<Load>> loads;
+        for(size_t i = 0; i < parts; i++) loads.push({0, i});
+        for(auto i: ScheduleLongestFirst(costs)) {
+            auto load = loads.top();
+            loads.pop();
+            part[i] = load.second;
+            loads.push({load.first + costs[i], load.second});
+        }
+        return part;
+    }
+
+} // namespace Kage
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "simplify.h"
+
+namespace Kage {
+
+    // 轮廓中的一段，type为PT_POINT时为直线段，只使用p[0]与p[3]
+    // 二次曲线只使用p[0]、p[1]与p[3]
+    typedef struct {
+        ptType type;
+        Point  p[4];
+    } SimplifySegment;
+
+    // 合并相邻三次曲线时允许的切线夹角（正弦值）
+    const double SIMPLIFY_TANGENT_SIN = 0.05;
+
+    // 检查合并结果时在每条原曲线上的取样数
+    const size_t SIMPLIFY_SAMPLES = 4;
+
+    void SimplifySegmentsOf(Contour&                      contour,
+                            std::vector<SimplifySegment>& segs) {
+        auto&  pts = contour.Points();
+        auto&  types = contour.PointTypes();
+        size_t n = pts.size(), start = 0;
+        bool   closed = contour.isClosed();
+        if(n < 2) return;
+        if(closed) {
+            start = n;
+            for(size_t i = 0; i < n; i++) {
+                if(types[i] == PT_POINT) {
+                    start = i;
+                    break;
+                }
+            }
+            if(start == n) return;
+        }
+        size_t i = start, walked = 0, limit = closed ? n : n - 1;
+        while(walked < limit) {
+            SimplifySegment seg;
+            size_t          j = (i + 1) % n, step;
+            if(types[j] == PT_POINT) {
+                seg.type = PT_POINT;
+                seg.p[0] = seg.p[1] = pts[i], seg.p[2] = seg.p[3] = pts[j];
+                step     = 1;
+            } else if(types[j] == PT_CUBIC && types[(j + 1) % n] == PT_CUBIC) {
+                seg.type = PT_CUBIC;
+                seg.p[0] = pts[i], seg.p[1] = pts[j],
+                seg.p[2] = pts[(j + 1) % n], seg.p[3] = pts[(j + 2) % n];
+                step     = 3;
+            } else {
+                seg.type = PT_QUAD;
+                seg.p[0] = pts[i], seg.p[1] = seg.p[2] = pts[j],
+                seg.p[3] = pts[(j + 1) % n];
+                step     = 2;
+            }
+            if(!closed && walked + step > limit) break; // 末尾不完整的曲线
+            segs.push_back(seg);
+            walked += step, i = (i + step) % n;
+        }
+    }
+
+    // 点到线段的距离
+    double SimplifyDistance(Point p, Point a, Point b) {
+        double dx = b.x - a.x, dy = b.y - a.y, l2 = dx * dx + dy * dy;
+        double t = l2 == 0 ? 0 : ((p.x - a.x) * dx + (p.y - a.y) * dy) / l2;
+        t = std::min(std::max(t, 0.0), 1.0);
+        return std::hypot(p.x - a.x - t * dx, p.y - a.y - t * dy);
+    }
+
+    Point SimplifyEval(SimplifySegment& s, double t) {
+        double mt = 1 - t;
+        if(s.type == PT_QUAD)
+            return Point(mt * mt * s.p[0].x + 2 * mt * t * s.p[1].x +
+                    t * t * s.p[3].x,
+                mt * mt * s.p[0].y + 2 * mt * t * s.p[1].y + t * t * s.p[3].y);
+        double a = mt * mt * mt, b = 3 * mt * mt * t, c = 3 * mt * t * t,
+               d = t * t * t;
+        return Point(a * s.p[0].x + b * s.p[1].x + c * s.p[2].x + d * s.p[3].x,
+            a * s.p[0].y + b * s.p[1].y + c * s.p[2].y + d * s.p[3].y);
+    }
+
+    // 去除零长度的段，控制点贴近弦的曲线改为直线
+    void SimplifyDegenerate(std::vector<SimplifySegment>& segs,
+        double tolerance) {
+        std::vector<SimplifySegment> result;
+        for(auto s: segs) {
+            if(s.type != PT_POINT &&
+                SimplifyDistance(s.p[1], s.p[0], s.p[3]) <= tolerance &&
+                SimplifyDistance(s.p[2], s.p[0], s.p[3]) <= tolerance)
+                s.type = PT_POINT, s.p[1] = s.p[0], s.p[2] = s.p[3];
+            if(s.type == PT_POINT && s.p[0] == s.p[3]) continue;
+            result.push_back(s);
+        }
+        segs.swap(result);
+    }
+
+    // 两段在连接处是否有可能合并
+    bool SimplifyJoinable(SimplifySegment& a, SimplifySegment& b,
+        double tolerance) {
+        if(a.type != b.type) return false;
+        if(a.type == PT_POINT)
+            return (a.p[3] - a.p[0]).Dot(b.p[3] - a.p[0]) > 0 &&
+                SimplifyDistance(a.p[3], a.p[0], b.p[3]) <= tolerance;
+        if(a.type != PT_CUBIC) return false;
+        Point  d1 = a.p[3] - a.p[2], d2 = b.p[1] - b.p[0];
+        double l1 = d1.GetLength(), l2 = d2.GetLength();
+        if(l1 == 0 || l2 == 0 || d1.Dot(d2) <= 0) return false;
+        return std::fabs(d1.x * d2.y - d1.y * d2.x) <=
+            SIMPLIFY_TANGENT_SIN * l1 * l2;
+    }
+
+    // 合并从first开始的一串直线段，返回合并的段数
+    size_t SimplifyMergeLines(std::vector<SimplifySegment>& segs, size_t first,
+        double tolerance, SimplifySegment& merged) {
+        merged      = segs[first];
+        size_t last = first;
+        for(size_t j = first + 1; j < segs.size(); j++) {
+            if(segs[j].type != PT_POINT) break;
+            Point a = segs[first].p[0], b = segs[j].p[3], chord = b - a;
+            bool  ok = true;
+            for(size_t k = first; k <= j && ok; k++) {
+                if((segs[k].p[3] - segs[k].p[0]).Dot(chord) <= 0) ok = false;
+                if(k < j && SimplifyDistance(segs[k].p[3], a, b) > tolerance)
+                    ok = false;
+            }
+            if(!ok) break;
+            merged.p[2] = merged.p[3] = b, last = j;
+        }
+        return last - first + 1;
+    }
+
+    // 合并从first开始的一串三次曲线，返回合并的段数
+    // 若曲线a在参数r处切分为a1、a2，则a的控制点可由a1、a2还原
+    size_t SimplifyMergeCubics(std::vector<SimplifySegment>& segs,
+        size_t first, double tolerance, SimplifySegment& merged) {
+        std::vector<double> u = {0, 1}; // 原曲线在merged上的参数分点
+        merged                = segs[first];
+        size_t last           = first;
+        for(size_t j = first + 1; j < segs.size(); j++) {
+            auto& b = segs[j];
+            if(!SimplifyJoinable(merged, b, tolerance)) break;
+            double l1 = (merged.p[3] - merged.p[2]).GetLength(),
+                   l2 = (b.p[1] - b.p[0]).GetLength(), r = l1 / (l1 + l2);
+            SimplifySegment c;
+            c.type = PT_CUBIC, c.p[0] = merged.p[0], c.p[3] = b.p[3];
+            c.p[1] = merged.p[0] + (merged.p[1] - merged.p[0]) / r;
+            c.p[2] = b.p[3] + (b.p[2] - b.p[3]) / (1 - r);
+            std::vector<double> v;
+            for(auto t: u)
+                v.push_back(t * r);
+            v.push_back(1);
+            // 与各原曲线比较，保证误差不累积
+            bool ok = true;
+            for(size_t k = first; k <= j && ok; k++) {
+                double t0 = v[k - first], t1 = v[k - first + 1];
+                for(size_t s = 0; s < SIMPLIFY_SAMPLES && ok; s++) {
+                    if(k == first && s == 0) continue;
+                    double t = (double)s / SIMPLIFY_SAMPLES;
+                    Point  p = SimplifyEval(segs[k], t),
+                           q = SimplifyEval(c, t0 + (t1 - t0) * t);
+                    if((p - q).GetLength() > tolerance || !q.isVaild())
+                        ok = false;
+                }
+            }
+            if(!ok) break;
+            merged = c, u.swap(v), last = j;
+        }
+        return last - first + 1;
+    }
+
+    double SimplifySnap(double v, double grid) {
+        return std::round(v / grid) * grid;
+    }
+
+    Contour SimplifyContour(Contour contour, double tolerance, double grid) {
+        std::vector<SimplifySegment> segs;
+        SimplifySegmentsOf(contour, segs);
+        if(segs.size() == 0) return contour;
+        SimplifyDegenerate(segs, tolerance);
+        // 闭合轮廓从无法合并的连接处开始，以免漏掉跨越起点的合并
+        if(contour.isClosed() && segs.size() > 1) {
+            for(size_t k = 0; k < segs.size(); k++) {
+                auto& prev = segs[(k + segs.size() - 1) % segs.size()];
+                if(!SimplifyJoinable(prev, segs[k], tolerance)) {
+                    std::rotate(segs.begin(), segs.begin() + k, segs.end());
+                    break;
+                }
+            }
+        }
+        std::vector<SimplifySegment> result;
+        for(size_t k = 0; k < segs.size();) {
+            SimplifySegment merged = segs[k];
+            size_t          count  = 1;
+            if(segs[k].type == PT_POINT)
+                count = SimplifyMergeLines(segs, k, tolerance, merged);
+            else if(segs[k].type == PT_CUBIC)
+                count = SimplifyMergeCubics(segs, k, tolerance, merged);
+            result.push_back(merged);
+            k += count;
+        }
+        if(grid > 0) {
+            for(auto& s: result) {
+                for(auto& p: s.p)
+                    p = Point(SimplifySnap(p.x, grid), SimplifySnap(p.y, grid));
+            }
+            SimplifyDegenerate(result, 0);
+        }
+        size_t lines = 0;
+        for(auto& s: result)
+            if(s.type == PT_POINT) lines++;
+        if(result.size() == 0 ||
+            (contour.isClosed() && lines == result.size() && lines < 3))
+            return contour;
+
+        Contour simplified;
+        simplified.MoveTo(result[0].p[0]);
+        for(size_t k = 0; k < result.size(); k++) {
+            auto& s = result[k];
+            if(s.type == PT_CUBIC)
+                simplified.CubicTo(s.p[1], s.p[2], s.p[3]);
+            else if(s.type == PT_QUAD)
+                simplified.QuadraticTo(s.p[1], s.p[3]);
+            else if(!contour.isClosed() || k + 1 < result.size() ||
+                s.p[3] != result[0].p[0]) // 闭合轮廓末尾回到起点的直线可省略
+                simplified.LineTo(s.p[3]);
+        }
+        simplified.SetClosed(contour.isClosed());
+        simplified.SetHole(contour.isHole());
+        if(simplified.Size() > contour.Size()) return contour;
+        return simplified;
+    }
+
+} // namespace Kage
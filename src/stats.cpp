@@ -0,0 +1,297 @@
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "stats.h"
+
+namespace Kage {
+
+    // 每个线程各自的计数，其他线程随时可以读取
+    typedef struct StatsBlock {
+        std::atomic<uint64_t> calls[STATS_STAGE_COUNT];
+        std::atomic<uint64_t> nanos[STATS_STAGE_COUNT];
+        std::atomic<uint64_t> allocs[STATS_STAGE_COUNT];
+        std::atomic<uint64_t> allocBytes[STATS_STAGE_COUNT];
+        std::atomic<uint64_t> strokeTypes[STATS_TYPE_SLOTS];
+        std::atomic<uint64_t> startTypes[STATS_TYPE_SLOTS];
+        std::atomic<uint64_t> endTypes[STATS_TYPE_SLOTS];
+
+        StatsBlock() {
+            Clear();
+        }
+
+        void Clear() {
+            for(auto& i: calls) i.store(0, std::memory_order_relaxed);
+            for(auto& i: nanos) i.store(0, std::memory_order_relaxed);
+            for(auto& i: allocs) i.store(0, std::memory_order_relaxed);
+            for(auto& i: allocBytes) i.store(0, std::memory_order_relaxed);
+            for(int i = 0; i < STATS_TYPE_SLOTS; i++) {
+                strokeTypes[i].store(0, std::memory_order_relaxed);
+                startTypes[i].store(0, std::memory_order_relaxed);
+                endTypes[i].store(0, std::memory_order_relaxed);
+            }
+        }
+    } StatsBlock;
+
+    // 运行中线程的计数表，以及已退出线程的合计
+    typedef struct {
+        std::mutex               mutex;
+        std::vector<StatsBlock*> blocks;
+        StatsBlock               retired;
+    } StatsRegistry;
+
+    StatsRegistry& StatsGlobal() {
+        static StatsRegistry registry;
+        return registry;
+    }
+
+    void StatsMerge(KageStats& out, StatsBlock const& block) {
+        for(int i = 0; i < STATS_STAGE_COUNT; i++) {
+            out.calls[i] += block.calls[i].load(std::memory_order_relaxed);
+            out.nanos[i] += block.nanos[i].load(std::memory_order_relaxed);
+            out.allocs[i] += block.allocs[i].load(std::memory_order_relaxed);
+            out.allocBytes[i] +=
+                block.allocBytes[i].load(std::memory_order_relaxed);
+        }
+        for(int i = 0; i < STATS_TYPE_SLOTS; i++) {
+            uint64_t v;
+            if((v = block.strokeTypes[i].load(std::memory_order_relaxed)))
+                out.strokeTypes[i] += v;
+            if((v = block.startTypes[i].load(std::memory_order_relaxed)))
+                out.startTypes[i] += v;
+            if((v = block.endTypes[i].load(std::memory_order_relaxed)))
+                out.endTypes[i] += v;
+        }
+    }
+
+    void StatsAccumulate(StatsBlock& to, StatsBlock const& from) {
+        for(int i = 0; i < STATS_STAGE_COUNT; i++) {
+            to.calls[i] += from.calls[i].load(std::memory_order_relaxed);
+            to.nanos[i] += from.nanos[i].load(std::memory_order_relaxed);
+            to.allocs[i] += from.allocs[i].load(std::memory_order_relaxed);
+            to.allocBytes[i] +=
+                from.allocBytes[i].load(std::memory_order_relaxed);
+        }
+        for(int i = 0; i < STATS_TYPE_SLOTS; i++) {
+            to.strokeTypes[i] +=
+                from.strokeTypes[i].load(std::memory_order_relaxed);
+            to.startTypes[i] +=
+                from.startTypes[i].load(std::memory_order_relaxed);
+            to.endTypes[i] += from.endTypes[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    // 线程退出时将计数并入retired
+    class StatsThreadBlock {
+    public:
+        StatsBlock* block;
+
+        StatsThreadBlock() {
+            block          = new StatsBlock();
+            auto& registry = StatsGlobal();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.blocks.push_back(block);
+        }
+        ~StatsThreadBlock() {
+            auto&                       registry = StatsGlobal();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            StatsAccumulate(registry.retired, *block);
+            for(auto it = registry.blocks.begin(); it != registry.blocks.end();
+                it++)
+                if(*it == block) {
+                    registry.blocks.erase(it);
+                    break;
+                }
+            delete block;
+        }
+    };
+
+    StatsBlock& StatsLocal() {
+        StatsGlobal(); // 保证注册表晚于线程的计数表析构
+        thread_local StatsThreadBlock block;
+        return *block.block;
+    }
+
+    KageStats StatsEmpty() {
+        KageStats stats;
+        for(int i = 0; i < STATS_STAGE_COUNT; i++)
+            stats.calls[i] = 0, stats.nanos[i] = 0, stats.allocs[i] = 0,
+            stats.allocBytes[i] = 0;
+        return stats;
+    }
+
+    KageStats GetStats() {
+        auto stats = StatsEmpty();
+#ifdef KAGE_ENABLE_STATS
+        auto&                       registry = StatsGlobal();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        StatsMerge(stats, registry.retired);
+        for(auto i: registry.blocks) StatsMerge(stats, *i);
+#endif
+        return stats;
+    }
+
+    KageStats GetThreadStats() {
+        auto stats = StatsEmpty();
+#ifdef KAGE_ENABLE_STATS
+        StatsMerge(stats, StatsLocal());
+#endif
+        return stats;
+    }
+
+    void ResetStats() {
+#ifdef KAGE_ENABLE_STATS
+        auto&                       registry = StatsGlobal();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.retired.Clear();
+        for(auto i: registry.blocks) i->Clear();
+#endif
+    }
+
+    void StatsAdd(StatsStage stage, uint64_t nanos, uint64_t allocs,
+        uint64_t allocBytes) {
+        auto& block = StatsLocal();
+        block.calls[stage].fetch_add(1, std::memory_order_relaxed);
+        block.nanos[stage].fetch_add(nanos, std::memory_order_relaxed);
+        if(allocs) {
+            block.allocs[stage].fetch_add(allocs, std::memory_order_relaxed);
+            block.allocBytes[stage].fetch_add(
+                allocBytes, std::memory_order_relaxed);
+        }
+    }
+
+#ifdef KAGE_ENABLE_ALLOC_STATS
+    // 只由所属线程读写，operator new中不能使用需要构造的thread_local
+    thread_local uint64_t statsThreadAllocs = 0, statsThreadAllocBytes = 0;
+
+    void StatsAllocCounters(uint64_t& allocs, uint64_t& bytes) {
+        allocs = statsThreadAllocs, bytes = statsThreadAllocBytes;
+    }
+
+    void* StatsAllocate(size_t size) {
+        statsThreadAllocs++, statsThreadAllocBytes += size;
+        return std::malloc(size ? size : 1);
+    }
+#else
+    void StatsAllocCounters(uint64_t& allocs, uint64_t& bytes) {
+        allocs = 0, bytes = 0;
+    }
+#endif
+
+    int StatsSlot(int type) {
+        return type < 0 || type >= STATS_TYPE_SLOTS ? STATS_TYPE_SLOTS - 1
+                                                    : type;
+    }
+
+    void StatsCountStroke(Stroke const& stroke) {
+        auto& block = StatsLocal();
+        block.strokeTypes[StatsSlot(stroke.type)].fetch_add(
+            1, std::memory_order_relaxed);
+        block.startTypes[StatsSlot(stroke.start)].fetch_add(
+            1, std::memory_order_relaxed);
+        block.endTypes[StatsSlot(stroke.end)].fetch_add(
+            1, std::memory_order_relaxed);
+    }
+
+    const char* StatsStageName(StatsStage stage) {
+        static const char* names[] = {"glyph", "parse", "resolve", "transform",
+            "adjust", "curve-sample", "curve-fit", "canva", "export"};
+        return stage < STATS_STAGE_COUNT ? names[stage] : "";
+    }
+
+    std::string FormatStats(KageStats const& stats) {
+#ifndef KAGE_ENABLE_STATS
+        (void)stats;
+        return "statistics disabled (build with KAGE_ENABLE_STATS)\n";
+#else
+        std::string out;
+        char        line[128];
+        std::snprintf(line, sizeof(line), "%-14s %12s %12s %10s", "stage",
+            "calls", "total(ms)", "avg(us)");
+        out += line;
+#    ifdef KAGE_ENABLE_ALLOC_STATS
+        std::snprintf(line, sizeof(line), " %12s %10s %10s", "allocs",
+            "avg", "avg(B)");
+        out += line;
+#    endif
+        out += "\n";
+        for(int i = 0; i < STATS_STAGE_COUNT; i++) {
+            double calls = stats.calls[i] ? stats.calls[i] : 1;
+            std::snprintf(line, sizeof(line), "%-14s %12llu %12.3f %10.3f",
+                StatsStageName((StatsStage)i),
+                (unsigned long long)stats.calls[i], stats.nanos[i] / 1e6,
+                stats.nanos[i] / 1e3 / calls);
+            out += line;
+#    ifdef KAGE_ENABLE_ALLOC_STATS
+            std::snprintf(line, sizeof(line), " %12llu %10.1f %10.1f",
+                (unsigned long long)stats.allocs[i], stats.allocs[i] / calls,
+                stats.allocBytes[i] / calls);
+            out += line;
+#    endif
+            out += "\n";
+        }
+        auto counts = [&](const char* title,
+                          std::map<int, uint64_t> const& types) {
+            out += title;
+            for(auto& i: types) {
+                std::snprintf(line, sizeof(line), " %d:%llu", i.first,
+                    (unsigned long long)i.second);
+                out += line;
+            }
+            out += "\n";
+        };
+        counts("stroke types:", stats.strokeTypes);
+        counts("start types:", stats.startTypes);
+        counts("end types:", stats.endTypes);
+        return out;
+#endif
+    }
+
+} // namespace Kage
+
+#ifdef KAGE_ENABLE_ALLOC_STATS
+// 替换全局的operator new以统计分配，delete须与之配对
+void* operator new(size_t size) {
+    void* p = Kage::StatsAllocate(size);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return Kage::StatsAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return Kage::StatsAllocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+#endif
@@ -0,0 +1,45 @@
+#include "symbol.h"
+
+namespace Kage {
+
+    SymbolTable::SymbolTable() {
+        _names.push_back("");
+        _ids[""] = 0;
+    }
+
+    uint32_t SymbolTable::Intern(std::string name) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto                        it = _ids.find(name);
+        if(it != _ids.end()) return it->second;
+        uint32_t id = _names.size();
+        _names.push_back(name);
+        _ids[name] = id;
+        return id;
+    }
+
+    // 查找已有的编号，不会新增
+    bool SymbolTable::Find(std::string name, uint32_t& id) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto                        it = _ids.find(name);
+        if(it == _ids.end()) return false;
+        id = it->second;
+        return true;
+    }
+
+    std::string SymbolTable::Name(uint32_t id) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return id < _names.size() ? _names[id] : "";
+    }
+
+    size_t SymbolTable::Size() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _names.size();
+    }
+
+    std::shared_ptr<SymbolTable> DefaultSymbolTable() {
+        static std::shared_ptr<SymbolTable> table =
+            std::make_shared<SymbolTable>();
+        return table;
+    }
+
+} // namespace Kage
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "trace.h"
+
+namespace Kage {
+
+    // 只由所属线程写入；generation与StartTrace的次数不同时在下次写入前清空
+    typedef struct {
+        std::vector<TraceEvent> events;
+        std::atomic<uint64_t>   next;
+        std::atomic<size_t>     generation;
+        size_t                  tid;
+        std::string             name;
+        bool                    exited;
+    } TraceBuffer;
+
+    typedef struct {
+        std::mutex                                mutex;
+        std::vector<std::unique_ptr<TraceBuffer>> buffers;
+        std::atomic<bool>                         active;
+        std::atomic<size_t>                       generation, capacity;
+        std::atomic<int64_t>                      origin; // 纳秒
+        size_t                                    nextTid;
+    } TraceRegistry;
+
+    TraceRegistry& TraceGlobal() {
+        static TraceRegistry registry;
+        return registry;
+    }
+
+    int64_t TraceClock() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // 线程退出后缓冲区仍保留到下次StartTrace，以便输出已结束的工作线程
+    class TraceThreadBuffer {
+    public:
+        TraceBuffer* buffer;
+
+        TraceThreadBuffer() {
+            auto&                       registry = TraceGlobal();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            buffer = new TraceBuffer();
+            buffer->next.store(0), buffer->generation.store(0);
+            buffer->tid = ++registry.nextTid, buffer->exited = false;
+            registry.buffers.emplace_back(buffer);
+        }
+        ~TraceThreadBuffer() {
+            auto&                       registry = TraceGlobal();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            buffer->exited = true;
+        }
+    };
+
+    TraceBuffer& TraceLocal() {
+        TraceGlobal(); // 保证注册表晚于线程的缓冲区析构
+        thread_local TraceThreadBuffer buffer;
+        return *buffer.buffer;
+    }
+
+    void StartTrace(size_t eventsPerThread) {
+        auto&                       registry = TraceGlobal();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.buffers.erase(
+            std::remove_if(registry.buffers.begin(), registry.buffers.end(),
+                [](std::unique_ptr<TraceBuffer> const& i) {
+                    return i->exited;
+                }),
+            registry.buffers.end());
+        registry.origin.store(TraceClock());
+        registry.capacity.store(std::max((size_t)1, eventsPerThread));
+        registry.generation++;
+        registry.active.store(true);
+    }
+
+    void StopTrace() {
+        TraceGlobal().active.store(false);
+    }
+
+    bool TraceActive() {
+        return TraceGlobal().active.load(std::memory_order_relaxed);
+    }
+
+    void TraceThreadName(std::string name) {
+        auto& buffer   = TraceLocal();
+        auto& registry = TraceGlobal();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        buffer.name = name;
+    }
+
+    uint64_t TraceNow() {
+        return TraceClock() -
+            TraceGlobal().origin.load(std::memory_order_relaxed);
+    }
+
+    void TraceRecord(const char* name, uint64_t begin, std::string const& arg) {
+        auto&  registry   = TraceGlobal();
+        auto&  buffer     = TraceLocal();
+        size_t generation = registry.generation.load();
+        if(buffer.generation.load(std::memory_order_relaxed) != generation) {
+            buffer.events.assign(registry.capacity.load(), TraceEvent());
+            buffer.next.store(0, std::memory_order_relaxed);
+            buffer.generation.store(generation, std::memory_order_release);
+        }
+        uint64_t index = buffer.next.load(std::memory_order_relaxed);
+        auto&    event = buffer.events[index % buffer.events.size()];
+        event.name = name, event.begin = begin, event.end = TraceNow();
+        size_t length = std::min(arg.size(), TRACE_ARG_SIZE - 1);
+        while(length < arg.size() && length > 0 &&
+            ((unsigned char)arg[length] & 0xC0) == 0x80)
+            length--; // 不截断UTF-8字符
+        std::memcpy(event.arg, arg.data(), length);
+        event.arg[length] = 0;
+        buffer.next.store(index + 1, std::memory_order_release);
+    }
+
+    void TraceEscape(std::ostream& out, const char* s) {
+        for(; *s; s++) {
+            if(*s == '"' || *s == '\\')
+                out << '\\' << *s;
+            else if((unsigned char)*s < 0x20) {
+                char hex[8];
+                std::snprintf(hex, sizeof(hex), "\\u%04x", *s);
+                out << hex;
+            } else
+                out << *s;
+        }
+    }
+
+    size_t WriteChromeTrace(std::ostream& out) {
+        auto&                       registry = TraceGlobal();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        size_t                      generation = registry.generation.load();
+        size_t                      count      = 0;
+        char                        time[64];
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        const char* separator = "";
+        for(auto& i: registry.buffers) {
+            if(i->generation.load(std::memory_order_acquire) != generation)
+                continue;
+            out << separator << "{\"name\":\"thread_name\",\"ph\":\"M\","
+                << "\"pid\":1,\"tid\":" << i->tid << ",\"args\":{\"name\":\"";
+            TraceEscape(out, i->name.empty()
+                    ? ("thread " + std::to_string(i->tid)).c_str()
+                    : i->name.c_str());
+            out << "\"}}";
+            separator     = ",";
+            uint64_t next = i->next.load(std::memory_order_acquire);
+            uint64_t first = next > i->events.size() ? next - i->events.size()
+                                                     : 0;
+            for(auto j = first; j < next; j++) {
+                auto& event = i->events[j % i->events.size()];
+                std::snprintf(time, sizeof(time), "%.3f,\"dur\":%.3f",
+                    event.begin / 1e3, (event.end - event.begin) / 1e3);
+                out << ",{\"name\":\"" << event.name
+                    << "\",\"cat\":\"kage\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                    << i->tid << ",\"ts\":" << time;
+                if(event.arg[0]) {
+                    out << ",\"args\":{\"name\":\"";
+                    TraceEscape(out, event.arg);
+                    out << "\"}";
+                }
+                out << "}";
+                count++;
+            }
+        }
+        out << "]}\n";
+        return count;
+    }
+
+} // namespace Kage